@@ -232,6 +232,36 @@ namespace fs
 		return this->write(buf.get(), total);
 	}
 
+	u64 file_base::read_at(u64 offset, void* buffer, u64 size)
+	{
+		// Fallback using the current position (not safe to call concurrently)
+		const u64 old_pos = seek(0, seek_cur);
+
+		if (old_pos == UINT64_MAX || seek(offset, seek_set) == UINT64_MAX)
+		{
+			return UINT64_MAX;
+		}
+
+		const u64 result = read(buffer, size);
+		seek(old_pos, seek_set);
+		return result;
+	}
+
+	u64 file_base::write_at(u64 offset, const void* buffer, u64 size)
+	{
+		// Fallback using the current position (not safe to call concurrently)
+		const u64 old_pos = seek(0, seek_cur);
+
+		if (old_pos == UINT64_MAX || seek(offset, seek_set) == UINT64_MAX)
+		{
+			return UINT64_MAX;
+		}
+
+		const u64 result = write(buffer, size);
+		seek(old_pos, seek_set);
+		return result;
+	}
+
 	dir_base::~dir_base()
 	{
 	}
@@ -931,7 +961,7 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 		share |= FILE_SHARE_WRITE | FILE_SHARE_DELETE;
 	}
 
-	const HANDLE handle = CreateFileW(to_wchar(path).get(), access, share, NULL, disp, FILE_ATTRIBUTE_NORMAL, NULL);
+	const HANDLE handle = CreateFileW(to_wchar(path).get(), access, share, NULL, disp, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
 
 	if (handle == INVALID_HANDLE_VALUE)
 	{
@@ -942,10 +972,42 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 	class windows_file final : public file_base
 	{
 		const HANDLE m_handle;
+		const bool m_append;
+
+		// The handle is opened for overlapped I/O so that positional reads and writes don't go through a shared file pointer,
+		// the position of sequential reads and writes is tracked here instead
+		u64 m_pos = 0;
+
+		// Transfers data at the specified offset and waits for completion, returns the error code
+		DWORD transfer(bool is_write, u64 offset, const void* buffer, DWORD size, DWORD& done)
+		{
+			// Requests of a thread don't overlap each other, so one event per thread is enough
+			thread_local const std::unique_ptr<void, decltype(&CloseHandle)> s_event(CreateEventW(NULL, TRUE, FALSE, NULL), &CloseHandle);
+			verify("file::transfer" HERE), s_event != nullptr;
+
+			OVERLAPPED ovl{};
+			ovl.Offset = static_cast<DWORD>(offset);
+			ovl.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			ovl.hEvent = s_event.get();
+
+			const BOOL started = is_write
+				? WriteFile(m_handle, buffer, size, NULL, &ovl)
+				: ReadFile(m_handle, const_cast<void*>(buffer), size, NULL, &ovl);
+
+			done = 0;
+
+			if ((!started && GetLastError() != ERROR_IO_PENDING) || !GetOverlappedResult(m_handle, &ovl, &done, TRUE))
+			{
+				return GetLastError();
+			}
+
+			return ERROR_SUCCESS;
+		}
 
 	public:
-		windows_file(HANDLE handle)
+		windows_file(HANDLE handle, bool append)
 			: m_handle(handle)
+			, m_append(append)
 		{
 		}
 
@@ -998,8 +1060,12 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			const int size = narrow<int>(count, "file::read" HERE);
 
 			DWORD nread;
-			verify("file::read" HERE), ReadFile(m_handle, buffer, size, &nread, NULL);
+			const DWORD error = transfer(false, m_pos, buffer, size, nread);
 
+			// Reading past the end fails with positional reads
+			verify("file::read" HERE), error == ERROR_SUCCESS || error == ERROR_HANDLE_EOF;
+
+			m_pos += nread;
 			return nread;
 		}
 
@@ -1008,30 +1074,53 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			// TODO (call WriteFile multiple times if count is too big)
 			const int size = narrow<int>(count, "file::write" HERE);
 
+			// Offset of all ones writes to the end of the file
 			DWORD nwritten;
-			verify("file::write" HERE), WriteFile(m_handle, buffer, size, &nwritten, NULL);
+			verify("file::write" HERE), transfer(true, m_append ? UINT64_MAX : m_pos, buffer, size, nwritten) == ERROR_SUCCESS;
 
+			m_pos = m_append ? this->size() : m_pos + nwritten;
 			return nwritten;
 		}
 
-		u64 seek(s64 offset, seek_mode whence) override
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			const int size = narrow<int>(count, "file::read_at" HERE);
+
+			DWORD nread;
+			const DWORD error = transfer(false, offset, buffer, size, nread);
+
+			// Reading past the end fails with positional reads
+			verify("file::read_at" HERE), error == ERROR_SUCCESS || error == ERROR_HANDLE_EOF;
+
+			return nread;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
 		{
-			LARGE_INTEGER pos;
-			pos.QuadPart = offset;
+			const int size = narrow<int>(count, "file::write_at" HERE);
 
-			const DWORD mode =
-				whence == seek_set ? FILE_BEGIN :
-				whence == seek_cur ? FILE_CURRENT :
-				whence == seek_end ? FILE_END :
+			DWORD nwritten;
+			verify("file::write_at" HERE), transfer(true, offset, buffer, size, nwritten) == ERROR_SUCCESS;
+
+			return nwritten;
+		}
+
+		u64 seek(s64 offset, seek_mode whence) override
+		{
+			const s64 pos =
+				whence == seek_set ? offset :
+				whence == seek_cur ? offset + static_cast<s64>(m_pos) :
+				whence == seek_end ? offset + static_cast<s64>(size()) :
 				(fmt::throw_exception("Invalid whence (0x%x)" HERE, whence), 0);
 
-			if (!SetFilePointerEx(m_handle, pos, &pos, mode))
+			if (pos < 0)
 			{
-				g_tls_error = to_error(GetLastError());
+				g_tls_error = error::inval;
 				return -1;
 			}
 
-			return pos.QuadPart;
+			m_pos = pos;
+			return m_pos;
 		}
 
 		u64 size() override
@@ -1048,7 +1137,7 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 		}
 	};
 
-	m_file = std::make_unique<windows_file>(handle);
+	m_file = std::make_unique<windows_file>(handle, (mode & fs::append) != 0);
 #else
 	int flags = 0;
 
@@ -1155,6 +1244,22 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			return result;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			const auto result = ::pread(m_fd, buffer, count, offset);
+			verify("file::read_at" HERE), result != -1;
+
+			return result;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			const auto result = ::pwrite(m_fd, buffer, count, offset);
+			verify("file::write_at" HERE), result != -1;
+
+			return result;
+		}
+
 		u64 seek(s64 offset, seek_mode whence) override
 		{
 			const int mode =
@@ -1245,6 +1350,23 @@ fs::file::file(const void* ptr, std::size_t size)
 			return 0;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			if (offset < m_size)
+			{
+				const u64 result = std::min<u64>(count, m_size - offset);
+				std::memcpy(buffer, m_ptr + offset, result);
+				return result;
+			}
+
+			return 0;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			return 0;
+		}
+
 		u64 seek(s64 offset, fs::seek_mode whence) override
 		{
 			const s64 new_pos =
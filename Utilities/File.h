@@ -86,6 +86,8 @@ namespace fs
 		virtual u64 size() = 0;
 		virtual native_handle get_handle();
 		virtual u64 write_gather(const iovec_clone* buffers, u64 buf_count);
+		virtual u64 read_at(u64 offset, void* buffer, u64 size);
+		virtual u64 write_at(u64 offset, const void* buffer, u64 size);
 	};
 
 	// Directory entry (TODO)
@@ -260,6 +262,20 @@ namespace fs
 			return m_file->write(buffer, count);
 		}
 
+		// Read the data at the offset, the current position is not used or changed (safe to call concurrently)
+		u64 read_at(u64 offset, void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->read_at(offset, buffer, count);
+		}
+
+		// Write the data at the offset, the current position is not used or changed (safe to call concurrently)
+		u64 write_at(u64 offset, const void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->write_at(offset, buffer, count);
+		}
+
 		// Change current position, returns resulting position
 		u64 seek(s64 offset, seek_mode whence = seek_set) const
 		{
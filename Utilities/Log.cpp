@@ -75,18 +75,23 @@ namespace logs
 #endif
 		uchar* m_fptr{};
 		z_stream m_zs{};
+		int m_zlevel = 0; // Current compression level
 		shared_mutex m_m;
 
 		alignas(128) atomic_t<u64> m_buf{0}; // MSB (40 bit): push begin, LSB (24 bis): push size
 		alignas(128) atomic_t<u64> m_out{0}; // Amount of bytes written to file
 
+		// Producers which had to wait for the writer thread because the buffer was full
+		atomic_t<u64> m_stalls{0};
+		atomic_t<u64> m_stall_time{0}; // µs
+
 		uchar m_zout[65536];
 
 		// Write buffered logs immediately
 		bool flush(u64 bufv);
 
 	public:
-		file_writer(const std::string& name);
+		file_writer(const std::string& name, const std::string& ext = ".log");
 
 		virtual ~file_writer();
 
@@ -118,6 +123,108 @@ namespace logs
 		std::string text;
 	};
 
+	// Binary log record types, every record starts with binary_record_header
+	enum class binary_record : u16
+	{
+		text = 1, // Formatted log line (rest of the record)
+		thread,   // u32 thread id, string name
+		format,   // u32 format id, u32 level, u8 argument types[count], string channel, string format
+		message,  // u64 stamp, u32 format id, u32 thread id, u64 arguments[count]
+	};
+
+	struct binary_record_header
+	{
+		binary_record type;
+		u16 count;
+		u32 size; // Full record size, including the header
+	};
+
+	// Binary log file header
+	constexpr char s_binary_magic[8]{'R', 'P', 'C', 'S', '3', 'B', 'L', 'G'};
+	constexpr u32 s_binary_version = 1;
+
+	// Argument types which can be formatted after the message has been sent: the argument is passed by value
+	// and the formatter doesn't depend on anything else. The index in this table is stored in the format record.
+	constexpr fmt_type_info s_binary_arg_types[]
+	{
+		fmt_type_info::make<bool>(),
+		fmt_type_info::make<char>(),
+		fmt_type_info::make<schar>(),
+		fmt_type_info::make<uchar>(),
+		fmt_type_info::make<short>(),
+		fmt_type_info::make<ushort>(),
+		fmt_type_info::make<int>(),
+		fmt_type_info::make<uint>(),
+		fmt_type_info::make<long>(),
+		fmt_type_info::make<ulong>(),
+		fmt_type_info::make<llong>(),
+		fmt_type_info::make<ullong>(),
+		fmt_type_info::make<float>(),
+		fmt_type_info::make<double>(),
+		fmt_type_info::make<const void*>(),
+	};
+
+	// Message source identified by the format text, the same address may hold different text over time
+	struct format_key
+	{
+		const message* msg;
+		const fmt_type_info* sup;
+		std::string fmt;
+
+		bool operator==(const format_key& rhs) const
+		{
+			return msg == rhs.msg && sup == rhs.sup && fmt == rhs.fmt;
+		}
+	};
+
+	struct format_key_hash
+	{
+		std::size_t operator()(const format_key& key) const
+		{
+			return std::hash<const void*>()(key.msg) ^ std::hash<std::string>()(key.fmt) * 31 ^ std::hash<const void*>()(key.sup) * 127;
+		}
+	};
+
+	// Message source identified by the format address, only used as a cache in front of format_key
+	struct format_site
+	{
+		const message* msg;
+		const char* fmt;
+		const fmt_type_info* sup;
+
+		bool operator==(const format_site& rhs) const
+		{
+			return msg == rhs.msg && fmt == rhs.fmt && sup == rhs.sup;
+		}
+	};
+
+	struct format_site_hash
+	{
+		std::size_t operator()(const format_site& key) const
+		{
+			return std::hash<const void*>()(key.msg) ^ std::hash<const void*>()(key.fmt) * 31 ^ std::hash<const void*>()(key.sup) * 127;
+		}
+	};
+
+	// Writes log messages as binary records, formatting is left to decode_binary_log()
+	class binary_writer : public file_writer
+	{
+		shared_mutex m_mutex;
+
+		// Format id for every message source, 0 if its arguments can't be stored raw
+		std::unordered_map<format_key, u32, format_key_hash> m_formats;
+		u32 m_format_count = 0;
+
+		atomic_t<u32> m_thread_count{0};
+
+		u32 register_format(const message& msg, const char* fmt, const fmt_type_info* sup, std::size_t count);
+
+	public:
+		binary_writer(const std::string& name);
+
+		void log(u64 stamp, const message& msg, const char* fmt, const fmt_type_info* sup, const u64* args, std::size_t count);
+	};
+
 	struct file_listener : public file_writer, public listener
 	{
 		file_listener(const std::string& name);
@@ -141,6 +248,12 @@ namespace logs
 		return &logger;
 	}
 
+	static binary_writer* get_binary_writer()
+	{
+		static binary_writer writer("RPCS3_binary");
+		return &writer;
+	}
+
 	static u64 get_stamp()
 	{
 		static struct time_initializer
@@ -188,6 +301,12 @@ namespace logs
 	// Must be set to true in main()
 	atomic_t<bool> g_init{false};
 
+	// Send messages to the binary writer instead of the main listener
+	atomic_t<bool> g_binary{false};
+
+	// zlib level of compressed logs
+	atomic_t<int> g_compression_level{9};
+
 	void reset()
 	{
 		std::lock_guard lock(g_mutex);
@@ -215,6 +334,101 @@ namespace logs
 			g_init = true;
 		}
 	}
+
+	void set_compression_level(int level)
+	{
+		g_compression_level = std::clamp(level, Z_NO_COMPRESSION, Z_BEST_COMPRESSION);
+	}
+
+	void set_binary(bool enable)
+	{
+		if (enable == g_binary)
+		{
+			return;
+		}
+
+		if (enable)
+		{
+			get_binary_writer();
+			LOG_NOTICE(GENERAL, "Binary log enabled, further messages are written to %sRPCS3_binary.blog", fs::get_cache_dir());
+		}
+
+		g_binary = enable;
+
+		if (!enable)
+		{
+			LOG_NOTICE(GENERAL, "Binary log disabled");
+		}
+	}
+
+	// Build a log file line: level, timestamp, prefix, channel and the message text
+	static void format_line(std::string& out, level sev, u64 stamp, const std::string& prefix, const char* ch_name, const std::string& text)
+	{
+		// Used character: U+00B7 (Middle Dot)
+		switch (sev)
+		{
+		case level::always:  out = u8"·A "; break;
+		case level::fatal:   out = u8"·F "; break;
+		case level::error:   out = u8"·E "; break;
+		case level::todo:    out = u8"·U "; break;
+		case level::success: out = u8"·S "; break;
+		case level::warning: out = u8"·W "; break;
+		case level::notice:  out = u8"·! "; break;
+		case level::trace:   out = u8"·T "; break;
+		case level::_uninit: out = u8"·  "; break;
+		}
+
+		// Print µs timestamp
+		const u64 hours = stamp / 3600'000'000;
+		const u64 mins = (stamp % 3600'000'000) / 60'000'000;
+		const u64 secs = (stamp % 60'000'000) / 1'000'000;
+		const u64 frac = (stamp % 1'000'000);
+		fmt::append(out, "%u:%02u:%02u.%06u ", hours, mins, secs, frac);
+
+		if (!prefix.empty())
+		{
+			out += "{";
+			out += prefix;
+			out += "} ";
+		}
+
+		if (ch_name && '\0' != *ch_name)
+		{
+			out += ch_name;
+			out += sev == level::todo ? " TODO: " : ": ";
+		}
+		else if (sev == level::todo)
+		{
+			out += "TODO: ";
+		}
+
+		out += text;
+		out += '\n';
+	}
+
+	template <typename T>
+	static void append_pod(std::string& out, const T& data)
+	{
+		out.append(reinterpret_cast<const char*>(&data), sizeof(T));
+	}
+
+	static void append_string(std::string& out, const std::string_view& str)
+	{
+		append_pod<u32>(out, ::narrow<u32>(str.size(), HERE));
+		out.append(str.data(), str.size());
+	}
+
+	static void begin_record(std::string& out, binary_record type, std::size_t count)
+	{
+		out.clear();
+		append_pod(out, binary_record_header{type, static_cast<u16>(count), 0});
+	}
+
+	static void end_record(std::string& out)
+	{
+		const u32 size = ::narrow<u32>(out.size(), HERE);
+		std::memcpy(&out[offsetof(binary_record_header, size)], &size, sizeof(size));
+	}
 }
 
 logs::listener::~listener()
@@ -270,7 +484,7 @@ void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, ...) co
 		}
 	}
 
-	// Get text, extract va_args
+	// Extract va_args
 	thread_local std::string text;
 	thread_local std::vector<u64> args;
 
@@ -286,12 +500,34 @@ void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, ...) co
 	for (u64& arg : args)
 		arg = va_arg(c_args, u64);
 	va_end(c_args);
-	fmt::raw_append(text, fmt, sup, args.data());
-	std::string prefix = g_tls_log_prefix();
 
 	// Get first (main) listener
 	listener* lis = get_logger();
 
+	if (g_binary && g_init)
+	{
+		get_binary_writer()->log(stamp, *this, fmt, sup, args.data(), args.size());
+
+		// The binary log replaces the main listener, only format the text if another listener wants it
+		lis = lis->m_next;
+
+		listener* next = lis;
+
+		while (next && !next->accepts(sev))
+		{
+			next = next->m_next;
+		}
+
+		if (!next)
+		{
+			return;
+		}
+	}
+
+	// Get text
+	fmt::raw_append(text, fmt, sup, args.data());
+	std::string prefix = g_tls_log_prefix();
+
 	if (!g_init)
 	{
 		std::lock_guard lock(g_mutex);
@@ -319,10 +555,10 @@ void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, ...) co
 
 [[noreturn]] extern void catch_all_exceptions();
 
-logs::file_writer::file_writer(const std::string& name)
+logs::file_writer::file_writer(const std::string& name, const std::string& ext)
 	: m_name(name)
 {
-	const std::string log_name = fs::get_cache_dir() + name + ".log";
+	const std::string log_name = fs::get_cache_dir() + name + ext;
 	const std::string buf_name = fs::get_cache_dir() + name + ".buf";
 
 	try
@@ -374,13 +610,15 @@ logs::file_writer::file_writer(const std::string& name)
 		// Rotate backups (TODO)
 		fs::remove_file(fs::get_cache_dir() + name + "1.log.gz");
 		fs::create_dir(fs::get_cache_dir() + "old_logs");
-		fs::rename(fs::get_cache_dir() + m_name + ".log.gz", fs::get_cache_dir() + "old_logs/" + m_name + ".log.gz", true);
+		fs::rename(fs::get_cache_dir() + m_name + ext + ".gz", fs::get_cache_dir() + "old_logs/" + m_name + ext + ".gz", true);
 
 		// Actual log file (allowed to fail)
 		m_fout.open(log_name, fs::rewrite);
 
 		// Compressed log, make it inaccessible (foolproof)
-		if (!m_fout2.open(log_name + ".gz", fs::rewrite + fs::unread) || deflateInit2(&m_zs, 9, Z_DEFLATED, 16 + 15, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		m_zlevel = g_compression_level;
+
+		if (!m_fout2.open(log_name + ".gz", fs::rewrite + fs::unread) || deflateInit2(&m_zs, m_zlevel, Z_DEFLATED, 16 + 15, 9, Z_DEFAULT_STRATEGY) != Z_OK)
 		{
 			m_fout2.close();
 		}
@@ -423,6 +661,12 @@ logs::file_writer::file_writer(const std::string& name)
 					break;
 				}
 
+				// Report waiting producers once everything is written out (cannot block on the full buffer now)
+				if (const u64 stalls = m_stalls.exchange(0))
+				{
+					LOG_WARNING(GENERAL, "Log writer fell behind: %u message(s) waited %u us in total for %s buffer space", stalls, m_stall_time.exchange(0), m_name);
+				}
+
 				std::this_thread::sleep_for(10ms);
 			}
 		}
@@ -497,6 +741,29 @@ bool logs::file_writer::flush(u64 bufv)
 		}
 
 		// Write compressed
+		if (m_fout2 && st < m_max_size)
+		{
+			if (const int level = g_compression_level; level != m_zlevel)
+			{
+				m_zs.avail_in = 0;
+				m_zs.next_in  = nullptr;
+				m_zs.avail_out = sizeof(m_zout);
+				m_zs.next_out  = m_zout;
+
+				// May need to flush pending data, retried on the next call if the output didn't fit
+				if (deflateParams(&m_zs, level, Z_DEFAULT_STRATEGY) == Z_OK)
+				{
+					m_zlevel = level;
+				}
+
+				if (m_fout2.write(m_zout, sizeof(m_zout) - m_zs.avail_out) != sizeof(m_zout) - m_zs.avail_out)
+				{
+					deflateEnd(&m_zs);
+					m_fout2.close();
+				}
+			}
+		}
+
 		if (m_fout2 && st < m_max_size)
 		{
 			m_zs.avail_in = size;
@@ -531,6 +798,9 @@ void logs::file_writer::log(logs::level sev, const char* text, std::size_t size)
 		return;
 	}
 
+	// Time when the buffer was found full
+	u64 stall_start = 0;
+
 	// TODO: write bigger fragment directly in blocking manner
 	while (size && size <= 0xffffff)
 	{
@@ -553,16 +823,27 @@ void logs::file_writer::log(logs::level sev, const char* text, std::size_t size)
 
 		if (UNLIKELY(!pos))
 		{
-			if ((bufv & 0xffffff) + size > 0xffffff || bufv & 0xffffff)
+			if ((bufv >> 24) + (bufv & 0xffffff) + size >= m_out + s_log_size)
 			{
-				// Concurrency limit reached
-				std::this_thread::yield();
-			}
-			else
-			{
-				// Queue is full, need to write out
-				flush(bufv);
+				if (std::this_thread::get_id() == m_writer.get_id())
+				{
+					// Queue is full, the writer thread can't wait for itself
+					if (!(bufv & 0xffffff))
+					{
+						flush(bufv);
+					}
+
+					continue;
+				}
+
+				// Queue is full, wait for the writer thread instead of compressing here
+				if (!stall_start)
+				{
+					stall_start = get_stamp();
+				}
 			}
+
+			std::this_thread::yield();
 			continue;
 		}
 
@@ -580,6 +861,12 @@ void logs::file_writer::log(logs::level sev, const char* text, std::size_t size)
 		m_buf += (u64{size} << 24) - size;
 		break;
 	}
+
+	if (UNLIKELY(stall_start))
+	{
+		m_stalls++;
+		m_stall_time += get_stamp() - stall_start;
+	}
 }
 
 logs::file_listener::file_listener(const std::string& name)
@@ -619,46 +906,347 @@ void logs::file_listener::log(u64 stamp, const logs::message& msg, const std::st
 {
 	thread_local std::string text;
 
-	// Used character: U+00B7 (Middle Dot)
-	switch (msg.sev)
+	format_line(text, msg.sev, stamp, prefix, msg.ch ? msg.ch->name : nullptr, _text);
+
+	file_writer::log(msg.sev, text.data(), text.size());
+}
+
+logs::binary_writer::binary_writer(const std::string& name)
+	: file_writer(name, ".blog")
+{
+	file_writer::log(level::always, s_binary_magic, sizeof(s_binary_magic));
+	file_writer::log(level::always, reinterpret_cast<const char*>(&s_binary_version), sizeof(s_binary_version));
+
+	// Same initial message as the text log
+	std::string record;
+	begin_record(record, binary_record::text, 0);
+	record += fmt::format("RPCS3 v%s | %s\n%s\n", rpcs3::version.to_string(), rpcs3::get_branch(), utils::get_system_info());
+	end_record(record);
+	file_writer::log(level::always, record.data(), record.size());
+}
+
+u32 logs::binary_writer::register_format(const message& msg, const char* fmt, const fmt_type_info* sup, std::size_t count)
+{
+	std::lock_guard lock(m_mutex);
+
+	format_key key{&msg, sup, fmt};
+
+	if (const auto found = m_formats.find(key); found != m_formats.end())
+	{
+		return found->second;
+	}
+
+	std::string record;
+	begin_record(record, binary_record::format, count);
+	append_pod<u32>(record, m_format_count + 1);
+	append_pod<u32>(record, static_cast<u32>(msg.sev));
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::size_t type = 0;
+
+		while (type < std::size(s_binary_arg_types) && s_binary_arg_types[type].fmt_string != sup[i].fmt_string)
+		{
+			type++;
+		}
+
+		if (type == std::size(s_binary_arg_types) || count > UINT16_MAX)
+		{
+			// Strings and other objects are passed by reference, they must be formatted immediately
+			m_formats.emplace(std::move(key), 0);
+			return 0;
+		}
+
+		append_pod(record, static_cast<u8>(type));
+	}
+
+	append_string(record, msg.ch ? msg.ch->name : "");
+	append_string(record, fmt);
+	end_record(record);
+
+	// Written under the lock, so that no message can refer to the format before its record
+	file_writer::log(msg.sev, record.data(), record.size());
+
+	m_formats.emplace(std::move(key), ++m_format_count);
+	return m_format_count;
+}
+
+void logs::binary_writer::log(u64 stamp, const message& msg, const char* fmt, const fmt_type_info* sup, const u64* args, std::size_t count)
+{
+	struct cached_format
+	{
+		u32 id;
+		std::string fmt;
+	};
+
+	thread_local std::unordered_map<format_site, cached_format, format_site_hash> formats;
+	thread_local u32 thread_id = 0;
+	thread_local std::string record;
+
+	if (UNLIKELY(!thread_id))
+	{
+		thread_id = ++m_thread_count;
+
+		begin_record(record, binary_record::thread, 0);
+		append_pod(record, thread_id);
+		append_string(record, thread_ctrl::get_current() ? std::string{thread_ctrl::get_name()} : g_tls_log_prefix());
+		end_record(record);
+		file_writer::log(level::always, record.data(), record.size());
+	}
+
+	// Messages without arguments are written as text: there is nothing to defer, and they are often runtime strings
+	u32 format_id = 0;
+
+	if (count)
+	{
+		const format_site site{&msg, fmt, sup};
+
+		auto found = formats.find(site);
+
+		// The text is compared as well, the format may be a runtime string whose address got reused
+		if (UNLIKELY(found == formats.end() || found->second.fmt != fmt))
+		{
+			found = formats.insert_or_assign(site, cached_format{register_format(msg, fmt, sup, count), fmt}).first;
+		}
+
+		format_id = found->second.id;
+	}
+
+	if (UNLIKELY(!format_id))
 	{
-	case level::always:  text = u8"·A "; break;
-	case level::fatal:   text = u8"·F "; break;
-	case level::error:   text = u8"·E "; break;
-	case level::todo:    text = u8"·U "; break;
-	case level::success: text = u8"·S "; break;
-	case level::warning: text = u8"·W "; break;
-	case level::notice:  text = u8"·! "; break;
-	case level::trace:   text = u8"·T "; break;
-	case level::_uninit: text = u8"·  "; break;
+		thread_local std::string text;
+		text.clear();
+		fmt::raw_append(text, fmt, sup, args);
+
+		begin_record(record, binary_record::text, 0);
+
+		thread_local std::string line;
+		format_line(line, msg.sev, stamp, g_tls_log_prefix(), msg.ch ? msg.ch->name : nullptr, text);
+		record += line;
+		end_record(record);
+		file_writer::log(msg.sev, record.data(), record.size());
+		return;
 	}
 
-	// Print µs timestamp
-	const u64 hours = stamp / 3600'000'000;
-	const u64 mins = (stamp % 3600'000'000) / 60'000'000;
-	const u64 secs = (stamp % 60'000'000) / 1'000'000;
-	const u64 frac = (stamp % 1'000'000);
-	fmt::append(text, "%u:%02u:%02u.%06u ", hours, mins, secs, frac);
+	begin_record(record, binary_record::message, count);
+	append_pod(record, stamp);
+	append_pod(record, format_id);
+	append_pod(record, thread_id);
+	record.append(reinterpret_cast<const char*>(args), count * sizeof(u64));
+	end_record(record);
+	file_writer::log(msg.sev, record.data(), record.size());
+}
+
+bool logs::decode_binary_log(const std::string& path, std::string out_path)
+{
+	fs::file in(path);
 
-	if (!prefix.empty())
+	if (!in)
 	{
-		text += "{";
-		text += prefix;
-		text += "} ";
+		LOG_ERROR(GENERAL, "Failed to open binary log %s (%s)", path, fs::g_tls_error);
+		return false;
 	}
 
-	if (msg.ch && '\0' != *msg.ch->name)
+	if (out_path.empty())
 	{
-		text += msg.ch->name;
-		text += msg.sev == level::todo ? " TODO: " : ": ";
+		out_path = path.substr(0, path.find_last_of('.')) + ".log";
 	}
-	else if (msg.sev == level::todo)
+
+	fs::file out(out_path, fs::rewrite);
+
+	if (!out)
 	{
-		text += "TODO: ";
+		LOG_ERROR(GENERAL, "Failed to create %s (%s)", out_path, fs::g_tls_error);
+		return false;
 	}
 
-	text += _text;
-	text += '\n';
+	// Read the input in big chunks, returns nullptr at the end of file
+	std::vector<uchar> buf;
+	std::size_t pos = 0;
 
-	file_writer::log(msg.sev, text.data(), text.size());
+	auto fetch = [&](std::size_t size) -> const uchar*
+	{
+		if (buf.size() - pos < size)
+		{
+			buf.erase(buf.begin(), buf.begin() + pos);
+			pos = 0;
+
+			const std::size_t old_size = buf.size();
+			buf.resize(old_size + std::max<std::size_t>(size, 1 << 20));
+			buf.resize(old_size + in.read(buf.data() + old_size, buf.size() - old_size));
+
+			if (buf.size() < size)
+			{
+				return nullptr;
+			}
+		}
+
+		const uchar* ptr = buf.data() + pos;
+		pos += size;
+		return ptr;
+	};
+
+	const uchar* header = fetch(sizeof(s_binary_magic) + sizeof(u32));
+
+	if (!header || std::memcmp(header, s_binary_magic, sizeof(s_binary_magic)) != 0 || *reinterpret_cast<const u32*>(header + sizeof(s_binary_magic)) != s_binary_version)
+	{
+		LOG_ERROR(GENERAL, "%s is not a binary log of this version", path);
+		return false;
+	}
+
+	struct decoded_format
+	{
+		level sev;
+		std::string channel;
+		std::string fmt;
+		std::vector<fmt_type_info> types; // Terminated with a null entry
+	};
+
+	std::unordered_map<u32, decoded_format> formats;
+	std::unordered_map<u32, std::string> threads;
+
+	std::string output = "\xEF\xBB\xBF";
+	std::string text, line;
+	std::vector<u64> args;
+	u64 num_records = 0;
+	u64 num_broken = 0;
+
+	while (const auto rec = reinterpret_cast<const binary_record_header*>(fetch(sizeof(binary_record_header))))
+	{
+		const binary_record_header head = *rec;
+
+		if (head.size < sizeof(binary_record_header))
+		{
+			LOG_ERROR(GENERAL, "Invalid record size in %s (0x%x)", path, head.size);
+			break;
+		}
+
+		const std::size_t size = head.size - sizeof(binary_record_header);
+		const uchar* data = fetch(size);
+
+		if (!data)
+		{
+			// Incomplete last record
+			break;
+		}
+
+		const uchar* const end = data + size;
+
+		auto read = [&](auto& value) -> bool
+		{
+			if (end - data < static_cast<std::ptrdiff_t>(sizeof(value)))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, data, sizeof(value));
+			data += sizeof(value);
+			return true;
+		};
+
+		auto read_string = [&](std::string& str) -> bool
+		{
+			u32 len = 0;
+
+			if (!read(len) || static_cast<std::size_t>(end - data) < len)
+			{
+				return false;
+			}
+
+			str.assign(reinterpret_cast<const char*>(data), len);
+			data += len;
+			return true;
+		};
+
+		num_records++;
+
+		switch (head.type)
+		{
+		case binary_record::text:
+		{
+			output.append(reinterpret_cast<const char*>(data), size);
+			break;
+		}
+		case binary_record::thread:
+		{
+			u32 id = 0;
+
+			if (!read(id) || !read_string(threads[id]))
+			{
+				num_broken++;
+			}
+
+			break;
+		}
+		case binary_record::format:
+		{
+			u32 id = 0, sev = 0;
+
+			if (!read(id) || !read(sev) || end - data < head.count)
+			{
+				num_broken++;
+				break;
+			}
+
+			decoded_format& format = formats[id];
+			format.sev = static_cast<level>(sev);
+			format.types.clear();
+
+			for (u32 i = 0; i < head.count; i++, data++)
+			{
+				format.types.push_back(s_binary_arg_types[std::min<std::size_t>(*data, std::size(s_binary_arg_types) - 1)]);
+			}
+
+			format.types.push_back({});
+
+			if (!read_string(format.channel) || !read_string(format.fmt))
+			{
+				formats.erase(id);
+				num_broken++;
+			}
+
+			break;
+		}
+		case binary_record::message:
+		{
+			u64 stamp = 0;
+			u32 id = 0, thread = 0;
+
+			const auto found = read(stamp) && read(id) && read(thread) ? formats.find(id) : formats.end();
+
+			if (found == formats.end() || found->second.types.size() != head.count + 1u || static_cast<std::size_t>(end - data) != head.count * sizeof(u64))
+			{
+				num_broken++;
+				break;
+			}
+
+			const decoded_format& format = found->second;
+
+			args.resize(head.count);
+			std::memcpy(args.data(), data, head.count * sizeof(u64));
+
+			text.clear();
+			fmt::raw_append(text, format.fmt.c_str(), format.types.data(), args.data());
+			format_line(line, format.sev, stamp, threads[thread], format.channel.c_str(), text);
+			output += line;
+			break;
+		}
+		default:
+		{
+			num_broken++;
+			break;
+		}
+		}
+
+		if (output.size() >= 1 << 20)
+		{
+			out.write(output);
+			output.clear();
+		}
+	}
+
+	out.write(output);
+
+	LOG_SUCCESS(GENERAL, "Decoded %u records from %s to %s (%u unreadable)", num_records, path, out_path, num_broken);
+	return num_broken == 0;
 }
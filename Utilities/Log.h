@@ -51,6 +51,12 @@ namespace logs
 		// Process log message
 		virtual void log(u64 stamp, const message& msg, const std::string& prefix, const std::string& text) = 0;
 
+		// Check whether messages of given severity are used (allows to skip formatting in binary mode)
+		virtual bool accepts(level sev) const
+		{
+			return true;
+		}
+
 		// Add new listener
 		static void add(listener*);
 	};
@@ -108,6 +114,15 @@ namespace logs
 
 	// Log level control: register channel if necessary, set channel level
 	void set_level(const std::string&, level);
+
+	// Set zlib compression level of RPCS3.log.gz (0-9), compression is done on a background thread
+	void set_compression_level(int level);
+
+	// Binary log mode: write raw arguments to RPCS3_binary.blog instead of formatting text for RPCS3.log
+	void set_binary(bool enable);
+
+	// Convert binary log to the text log format, output path defaults to the input path with .log extension
+	bool decode_binary_log(const std::string& path, std::string out_path = {});
 }
 
 #define LOG_CHANNEL(ch, ...) ::logs::channel ch(#ch, ##__VA_ARGS__)
@@ -9,8 +9,11 @@
 #include "Emu/Cell/lv2/sys_event.h"
 #include "Thread.h"
 #include "sysinfo.h"
+#include "asm.h"
 #include <typeinfo>
 #include <thread>
+#include <algorithm>
+#include <cctype>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -1943,141 +1946,326 @@ u64 thread_base::get_cycles()
 	}
 }
 
-void thread_ctrl::detect_cpu_layout()
+namespace
 {
-	if (!g_native_core_layout.compare_and_swap_test(native_core_arrangement::undefined, native_core_arrangement::generic))
-		return;
-
-	const auto system_id = utils::get_system_info();
-	if (system_id.find("Ryzen") != std::string::npos)
+	// Logical CPU sets of the host, limited to the first 64 logical CPUs (processor group 0 on Windows)
+	struct cpu_topology
 	{
-		g_native_core_layout.store(native_core_arrangement::amd_ccx);
-	}
-	else if (system_id.find("Intel") != std::string::npos)
-	{
-#ifdef _WIN32
-		const LOGICAL_PROCESSOR_RELATIONSHIP relationship = LOGICAL_PROCESSOR_RELATIONSHIP::RelationProcessorCore;
-		DWORD buffer_size = 0;
+		u64 available = 0;     // CPUs this process is allowed to run on
+		std::vector<u64> cores; // SMT siblings of every physical core
+		std::vector<u64> l3;    // CPUs sharing an L3 cache
+		std::vector<u64> nodes; // NUMA nodes
 
-		// If buffer size is set to 0 bytes, it will be overwritten with the required size
-		if (GetLogicalProcessorInformationEx(relationship, nullptr, &buffer_size))
+		static void add_unique(std::vector<u64>& sets, u64 mask)
 		{
-			LOG_ERROR(GENERAL, "GetLogicalProcessorInformationEx returned 0 bytes");
-			return;
+			if (mask && std::find(sets.begin(), sets.end(), mask) == sets.end())
+			{
+				sets.push_back(mask);
+			}
 		}
-		DWORD error_code = GetLastError();
-		if (error_code != ERROR_INSUFFICIENT_BUFFER)
+
+#if defined(__linux__)
+		static std::string read_sysfs(const std::string& path)
 		{
-			LOG_ERROR(GENERAL, "Unexpected windows error code when detecting CPU layout: %u", error_code);
-			return;
-		}
+			// sysfs reports a fake file size, so fs::file::to_string() can't be used
+			std::string result(256, '\0');
 
-		std::vector<u8> buffer(buffer_size);
+			if (fs::file file{path})
+			{
+				result.resize(file.read(&result[0], result.size()));
+			}
+			else
+			{
+				result.clear();
+			}
 
-		if (!GetLogicalProcessorInformationEx(relationship,
-			reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data()), &buffer_size))
-		{
-			LOG_ERROR(GENERAL, "GetLogicalProcessorInformationEx failed (size=%u, error=%u)", buffer_size, GetLastError());
+			return result;
 		}
-		else
+
+		// Parse CPU list format, e.g. "0-3,8-11"
+		static u64 parse_cpu_list(const std::string& list)
 		{
-			// Iterate through the buffer until a core with hyperthreading is found
-			auto ptr = reinterpret_cast<std::uintptr_t>(buffer.data());
-			const std::uintptr_t end = ptr + buffer_size;
+			u64 result = 0;
 
-			while (ptr < end)
+			for (std::size_t pos = 0; pos < list.size() && std::isdigit(static_cast<uchar>(list[pos]));)
 			{
-				auto info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(ptr);
-				if (info->Relationship == relationship && info->Processor.Flags == LTP_PC_SMT)
+				std::size_t len = 0;
+				const u32 first = std::stoul(list.substr(pos), &len);
+				u32 last = first;
+				pos += len;
+
+				if (pos < list.size() && list[pos] == '-')
 				{
-					g_native_core_layout.store(native_core_arrangement::intel_ht);
-					break;
+					last = std::stoul(list.substr(++pos), &len);
+					pos += len;
 				}
-				ptr += info->Size;
-			}
-		}
-#else
-		LOG_TODO(GENERAL, "Thread scheduler is not implemented for Intel and this OS");
-#endif
-	}
-}
 
-u16 thread_ctrl::get_affinity_mask(thread_class group)
-{
-	detect_cpu_layout();
+				for (u32 cpu = first; cpu <= last && cpu < 64; cpu++)
+				{
+					result |= 1ull << cpu;
+				}
 
-	if (const auto thread_count = std::thread::hardware_concurrency())
-	{
-		const u16 all_cores_mask = thread_count < 16 ? (u16)(~(UINT16_MAX << thread_count)): UINT16_MAX;
+				if (pos < list.size() && list[pos] == ',')
+				{
+					pos++;
+				}
+			}
 
-		switch (g_native_core_layout)
-		{
-		default:
-		case native_core_arrangement::generic:
-		{
-			return all_cores_mask;
+			return result;
 		}
-		case native_core_arrangement::amd_ccx:
+#endif
+
+		cpu_topology()
 		{
-			u16 spu_mask, ppu_mask, rsx_mask;
-			if (thread_count >= 16)
+#ifdef _WIN32
+			DWORD_PTR process_mask = 0, system_mask = 0;
+
+			if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
 			{
-				// Threadripper, R7
-				// Assign threads 8-16
-				// It appears some windows code is bound to lower core addresses, binding 8-16 is alot faster than 0-7
-				ppu_mask = spu_mask = 0b1111111100000000;
-				rsx_mask = all_cores_mask;
+				available = process_mask;
 			}
-			else if (thread_count == 12)
+
+			DWORD buffer_size = 0;
+			GetLogicalProcessorInformationEx(RelationAll, nullptr, &buffer_size);
+			std::vector<u8> buffer(buffer_size);
+
+			if (buffer_size && GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data()), &buffer_size))
 			{
-				// 1600/2600 (x)
-				ppu_mask = spu_mask = 0b111111000000;
-				rsx_mask = all_cores_mask;
+				for (std::size_t pos = 0; pos < buffer_size;)
+				{
+					const auto info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + pos);
+
+					switch (info->Relationship)
+					{
+					case RelationProcessorCore:
+					{
+						if (info->Processor.GroupMask[0].Group == 0)
+						{
+							add_unique(cores, info->Processor.GroupMask[0].Mask);
+						}
+
+						break;
+					}
+					case RelationCache:
+					{
+						if (info->Cache.Level == 3 && info->Cache.GroupMask.Group == 0)
+						{
+							add_unique(l3, info->Cache.GroupMask.Mask);
+						}
+
+						break;
+					}
+					case RelationNumaNode:
+					{
+						if (info->NumaNode.GroupMask.Group == 0)
+						{
+							add_unique(nodes, info->NumaNode.GroupMask.Mask);
+						}
+
+						break;
+					}
+					default: break;
+					}
+
+					pos += info->Size;
+				}
 			}
 			else
 			{
-				// R5 & R3 don't seem to improve performance no matter how these are shuffled
-				ppu_mask = spu_mask = rsx_mask = 0b11111111 & all_cores_mask;
+				LOG_ERROR(GENERAL, "GetLogicalProcessorInformationEx failed (size=%u, error=%u)", buffer_size, GetLastError());
+			}
+#elif defined(__linux__)
+			cpu_set_t cs;
+			CPU_ZERO(&cs);
+
+			if (sched_getaffinity(getpid(), sizeof(cs), &cs) == 0)
+			{
+				for (u32 cpu = 0; cpu < 64; cpu++)
+				{
+					if (CPU_ISSET(cpu, &cs))
+					{
+						available |= 1ull << cpu;
+					}
+				}
+			}
+
+			const std::string sys_cpu = "/sys/devices/system/cpu/cpu";
+
+			for (u64 mask = available; mask; mask &= mask - 1)
+			{
+				const std::string cpu = sys_cpu + std::to_string(utils::cnttz64(mask)) + "/";
+
+				add_unique(cores, parse_cpu_list(read_sysfs(cpu + "topology/thread_siblings_list")));
+
+				for (u32 index = 0; fs::is_dir(cpu + fmt::format("cache/index%u", index)); index++)
+				{
+					const std::string cache = cpu + fmt::format("cache/index%u/", index);
+
+					if (read_sysfs(cache + "level").compare(0, 1, "3") == 0)
+					{
+						add_unique(l3, parse_cpu_list(read_sysfs(cache + "shared_cpu_list")));
+					}
+				}
+			}
+
+			for (u32 node = 0; fs::is_dir(fmt::format("/sys/devices/system/node/node%u", node)); node++)
+			{
+				add_unique(nodes, parse_cpu_list(read_sysfs(fmt::format("/sys/devices/system/node/node%u/cpulist", node))));
 			}
+#endif
 
-			switch (group)
+			if (!available)
 			{
-			default:
-			case thread_class::general:
-				return all_cores_mask;
-			case thread_class::rsx:
-				return rsx_mask;
-			case thread_class::ppu:
-				return ppu_mask;
-			case thread_class::spu:
-				return spu_mask;
+				const u32 count = std::min(std::max(std::thread::hardware_concurrency(), 1u), 64u);
+				available = count == 64 ? UINT64_MAX : ~(UINT64_MAX << count);
+			}
+
+			// Fill in what couldn't be detected: no SMT, a single L3 cache and NUMA node
+			if (cores.empty())
+			{
+				for (u64 mask = available; mask; mask &= mask - 1)
+				{
+					cores.push_back(mask & (0 - mask));
+				}
 			}
+
+			if (l3.empty())
+			{
+				l3.push_back(available);
+			}
+
+			if (nodes.empty())
+			{
+				nodes.push_back(available);
+			}
+
+			// Order clusters by their lowest CPU
+			std::sort(l3.begin(), l3.end(), [](u64 a, u64 b) { return (a & (0 - a)) < (b & (0 - b)); });
+
+			LOG_NOTICE(GENERAL, "CPU topology: %u logical CPUs, %u cores, %u L3 clusters, %u NUMA nodes (available: 0x%llx)",
+				utils::popcnt64(available), cores.size(), l3.size(), nodes.size(), available);
 		}
-		case native_core_arrangement::intel_ht:
+
+		// Index of the first NUMA node containing any of the CPUs
+		std::size_t get_node(u64 mask) const
 		{
-			/* This has been disabled as it seems to degrade performance instead of improving it.
-			if (thread_count <= 4)
+			for (std::size_t i = 0; i < nodes.size(); i++)
 			{
-				//i3 or worse
-				switch (group)
+				if (nodes[i] & mask)
 				{
-				case thread_class::rsx:
-				case thread_class::ppu:
-					return (0b0101 & all_cores_mask);
-				case thread_class::spu:
-					return (0b1010 & all_cores_mask);
-				case thread_class::general:
-					return all_cores_mask;
+					return i;
 				}
 			}
-			*/
 
-			return all_cores_mask;
+			return 0;
 		}
+	};
+
+	const cpu_topology& get_cpu_topology()
+	{
+		static const cpu_topology topology;
+		return topology;
+	}
+}
+
+void thread_ctrl::detect_cpu_layout()
+{
+	if (!g_native_core_layout.compare_and_swap_test(native_core_arrangement::undefined, native_core_arrangement::generic))
+		return;
+
+	const auto& topology = get_cpu_topology();
+
+	if (topology.l3.size() > 1)
+	{
+		g_native_core_layout.store(native_core_arrangement::amd_ccx);
+	}
+	else if (topology.cores.size() < static_cast<std::size_t>(utils::popcnt64(topology.available)))
+	{
+		g_native_core_layout.store(native_core_arrangement::intel_ht);
+	}
+}
+
+u64 thread_ctrl::get_affinity_mask(thread_class group)
+{
+	detect_cpu_layout();
+
+	const auto& topology = get_cpu_topology();
+
+	if (group == thread_class::general)
+	{
+		return topology.available;
+	}
+
+	// Leave whole physical cores (from the lowest) to the OS and other threads, keeping at least one
+	u64 usable = topology.available;
+
+	for (u32 i = 0, reserved = g_cfg.core.reserved_cores; i < topology.cores.size() && reserved; i++)
+	{
+		if (usable & ~topology.cores[i])
+		{
+			usable &= ~topology.cores[i];
+			reserved--;
+		}
+	}
+
+	std::vector<u64> clusters;
+
+	for (u64 l3 : topology.l3)
+	{
+		if (l3 & usable)
+		{
+			clusters.push_back(l3 & usable);
+		}
+	}
+
+	if (clusters.size() < 2)
+	{
+		return usable;
+	}
+
+	// PPU and SPU threads constantly hit the same reservations, so keep them in as few shared-L3 clusters as possible.
+	// Clusters are taken from the highest CPUs because some system code is bound to the lowest ones.
+	// Fewer CPUs than that are not worth separating from RSX (two PPU threads and most SPU threads).
+	constexpr u32 min_emu_cpus = 6;
+
+	const std::size_t node = topology.get_node(clusters.back());
+	u64 emu_mask = 0;
+
+	for (auto it = clusters.rbegin(); it != clusters.rend() && utils::popcnt64(emu_mask) < min_emu_cpus; it++)
+	{
+		if (topology.get_node(*it) == node)
+		{
+			emu_mask |= *it;
+		}
+	}
+
+	for (auto it = clusters.rbegin(); it != clusters.rend() && utils::popcnt64(emu_mask) < min_emu_cpus; it++)
+	{
+		emu_mask |= *it;
+	}
+
+	if (group == thread_class::ppu || group == thread_class::spu)
+	{
+		return emu_mask;
+	}
+
+	// RSX gets the remaining clusters on the same NUMA node, or any remaining CPUs
+	u64 rsx_mask = 0;
+
+	for (u64 cluster : clusters)
+	{
+		if (!(cluster & emu_mask) && topology.get_node(cluster) == node)
+		{
+			rsx_mask |= cluster;
 		}
 	}
 
-	return UINT16_MAX;
+	if (!rsx_mask)
+	{
+		rsx_mask = usable & ~emu_mask;
+	}
+
+	return rsx_mask ? rsx_mask : usable;
 }
 
 void thread_ctrl::set_native_priority(int priority)
@@ -2113,7 +2301,7 @@ void thread_ctrl::set_native_priority(int priority)
 #endif
 }
 
-void thread_ctrl::set_thread_affinity_mask(u16 mask)
+void thread_ctrl::set_thread_affinity_mask(u64 mask)
 {
 #ifdef _WIN32
 	HANDLE _this_thread = GetCurrentThread();
@@ -2126,9 +2314,9 @@ void thread_ctrl::set_thread_affinity_mask(u16 mask)
 	cpu_set_t cs;
 	CPU_ZERO(&cs);
 
-	for (u32 core = 0; core < 16u; ++core)
+	for (u32 core = 0; core < 64u; ++core)
 	{
-		if ((u32)mask & (1u << core))
+		if (mask & (1ull << core))
 		{
 			CPU_SET(core, &cs);
 		}
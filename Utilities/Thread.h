@@ -257,14 +257,14 @@ public:
 	// Detect layout
 	static void detect_cpu_layout();
 
-	// Returns a core affinity mask. Set whether to generate the high priority set or not
-	static u16 get_affinity_mask(thread_class group);
+	// Returns a logical CPU mask for the thread group, based on the shared-L3 and NUMA layout of the host (first 64 CPUs)
+	static u64 get_affinity_mask(thread_class group);
 
 	// Sets the native thread priority
 	static void set_native_priority(int priority);
 
 	// Sets the preferred affinity mask for this thread
-	static void set_thread_affinity_mask(u16 mask);
+	static void set_thread_affinity_mask(u64 mask);
 
 	// Spawn a detached named thread
 	template <typename F>
@@ -0,0 +1,475 @@
+#include "stdafx.h"
+#include "aio.h"
+
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define AIO_HAS_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace fs
+{
+#ifdef AIO_HAS_URING
+	struct aio_engine::uring
+	{
+		// Ring size, also the limit of requests in flight (the rest waits in the queue)
+		static constexpr u32 depth = 64;
+
+		// Tag of the request submitted to stop the completion thread
+		static constexpr u64 stop_tag = UINT64_MAX;
+
+		int fd = -1;
+
+		void* sq_ring = MAP_FAILED;
+		void* cq_ring = MAP_FAILED;
+		void* sqe_ring = MAP_FAILED;
+		std::size_t sq_ring_size = 0;
+		std::size_t cq_ring_size = 0;
+		std::size_t sqe_ring_size = 0;
+
+		atomic_t<u32>* sq_tail = nullptr;
+		u32* sq_array = nullptr;
+		u32 sq_mask = 0;
+		io_uring_sqe* sqes = nullptr;
+
+		atomic_t<u32>* cq_head = nullptr;
+		atomic_t<u32>* cq_tail = nullptr;
+		u32 cq_mask = 0;
+		io_uring_cqe* cqes = nullptr;
+
+		// Requests in flight, indexed by the user data of the submission
+		struct slot
+		{
+			request req;
+			iovec iov;
+		};
+
+		std::mutex mutex;
+		std::condition_variable idle;
+		std::vector<slot> slots;
+		std::vector<u32> free_slots;
+		std::deque<request> waiting;
+
+		std::unique_ptr<named_thread<std::function<void()>>> thread;
+
+		// Returns the error code if the kernel doesn't provide io_uring
+		int init()
+		{
+			io_uring_params params{};
+
+			fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+
+			if (fd < 0)
+			{
+				return errno;
+			}
+
+			sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+			cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+			if (params.features & IORING_FEAT_SINGLE_MMAP)
+			{
+				sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+			}
+
+			sq_ring = ::mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+			if (sq_ring == MAP_FAILED)
+			{
+				return errno;
+			}
+
+			if (params.features & IORING_FEAT_SINGLE_MMAP)
+			{
+				cq_ring = sq_ring;
+			}
+			else if (cq_ring = ::mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING); cq_ring == MAP_FAILED)
+			{
+				return errno;
+			}
+
+			sqe_ring_size = params.sq_entries * sizeof(io_uring_sqe);
+			sqe_ring = ::mmap(nullptr, sqe_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+			if (sqe_ring == MAP_FAILED)
+			{
+				return errno;
+			}
+
+			const auto sq = static_cast<u8*>(sq_ring);
+			const auto cq = static_cast<u8*>(cq_ring);
+
+			sq_tail = reinterpret_cast<atomic_t<u32>*>(sq + params.sq_off.tail);
+			sq_array = reinterpret_cast<u32*>(sq + params.sq_off.array);
+			sq_mask = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+			sqes = static_cast<io_uring_sqe*>(sqe_ring);
+
+			cq_head = reinterpret_cast<atomic_t<u32>*>(cq + params.cq_off.head);
+			cq_tail = reinterpret_cast<atomic_t<u32>*>(cq + params.cq_off.tail);
+			cq_mask = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+			// Keep one submission free for the stop request
+			const u32 max_in_flight = std::min<u32>(depth, params.sq_entries) - 1;
+
+			slots.resize(max_in_flight);
+
+			for (u32 i = max_in_flight; i > 0; i--)
+			{
+				free_slots.push_back(i - 1);
+			}
+
+			thread = std::make_unique<named_thread<std::function<void()>>>("FS AIO Completion", [this] { complete(); });
+			return 0;
+		}
+
+		~uring()
+		{
+			if (thread)
+			{
+				// Wait for the requests in flight, then stop the completion thread
+				std::unique_lock lock(mutex);
+				idle.wait(lock, [&] { return free_slots.size() == slots.size() && waiting.empty(); });
+
+				io_uring_sqe& sqe = next_sqe();
+				sqe.opcode = IORING_OP_NOP;
+				sqe.user_data = stop_tag;
+				enter(1);
+				lock.unlock();
+
+				thread.reset();
+			}
+
+			if (sqe_ring != MAP_FAILED) ::munmap(sqe_ring, sqe_ring_size);
+			if (cq_ring != MAP_FAILED && cq_ring != sq_ring) ::munmap(cq_ring, cq_ring_size);
+			if (sq_ring != MAP_FAILED) ::munmap(sq_ring, sq_ring_size);
+			if (fd >= 0) ::close(fd);
+		}
+
+		// Get a cleared submission entry and publish it (submitted by the next enter(), mutex must be locked)
+		io_uring_sqe& next_sqe()
+		{
+			const u32 tail = sq_tail->load();
+			const u32 index = tail & sq_mask;
+
+			io_uring_sqe& sqe = sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sq_array[index] = index;
+			sq_tail->store(tail + 1);
+			return sqe;
+		}
+
+		// Only native files can be used, readv/writev transfer less than 2 GiB at once
+		static bool accepts(const request& req)
+		{
+			return req.handle->get_handle() >= 0 && req.size <= 0x7ffff000;
+		}
+
+		// Prepare the request in a free slot (mutex must be locked)
+		void prepare(request&& req)
+		{
+			const u32 index = free_slots.back();
+			free_slots.pop_back();
+
+			slot& s = slots[index];
+			s.req = std::move(req);
+			s.iov.iov_base = s.req.buffer;
+			s.iov.iov_len = s.req.size;
+
+			io_uring_sqe& sqe = next_sqe();
+			sqe.opcode = s.req.is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+			sqe.fd = s.req.handle->get_handle();
+			sqe.off = s.req.offset;
+			sqe.addr = reinterpret_cast<u64>(&s.iov);
+			sqe.len = 1;
+			sqe.user_data = index;
+		}
+
+		// Submit the prepared requests (mutex must be locked)
+		void enter(u32 count)
+		{
+			while (count)
+			{
+				const int result = static_cast<int>(::syscall(__NR_io_uring_enter, fd, count, 0, 0, nullptr, 0));
+
+				if (result < 0)
+				{
+					verify("io_uring_enter" HERE), errno == EINTR || errno == EAGAIN;
+					continue;
+				}
+
+				count -= result;
+			}
+		}
+
+		void submit(std::vector<request>&& requests)
+		{
+			std::lock_guard lock(mutex);
+
+			u32 count = 0;
+
+			for (auto& req : requests)
+			{
+				if (free_slots.empty())
+				{
+					waiting.emplace_back(std::move(req));
+					continue;
+				}
+
+				prepare(std::move(req));
+				count++;
+			}
+
+			enter(count);
+		}
+
+		// Remove a request which waits for a free slot
+		bool cancel(u64 id, request& out)
+		{
+			std::lock_guard lock(mutex);
+
+			const auto found = std::find_if(waiting.begin(), waiting.end(), [&](const request& req) { return req.id == id; });
+
+			if (found == waiting.end())
+			{
+				return false;
+			}
+
+			out = std::move(*found);
+			waiting.erase(found);
+			return true;
+		}
+
+		// Completion thread
+		void complete()
+		{
+			std::vector<std::pair<request, s32>> done;
+
+			while (true)
+			{
+				if (::syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+				{
+					verify("io_uring_enter" HERE), errno == EINTR;
+				}
+
+				bool stop = false;
+
+				{
+					std::lock_guard lock(mutex);
+
+					const u32 tail = cq_tail->load();
+					u32 head = cq_head->load();
+
+					for (; head != tail; head++)
+					{
+						const io_uring_cqe& cqe = cqes[head & cq_mask];
+
+						if (cqe.user_data == stop_tag)
+						{
+							stop = true;
+							continue;
+						}
+
+						const u32 index = static_cast<u32>(cqe.user_data);
+						done.emplace_back(std::move(slots[index].req), cqe.res);
+						free_slots.push_back(index);
+					}
+
+					cq_head->store(head);
+
+					// Submit the requests which waited for a free slot
+					u32 count = 0;
+
+					for (; !waiting.empty() && !free_slots.empty(); count++)
+					{
+						prepare(std::move(waiting.front()));
+						waiting.pop_front();
+					}
+
+					enter(count);
+
+					if (free_slots.size() == slots.size() && waiting.empty())
+					{
+						idle.notify_all();
+					}
+				}
+
+				for (auto& [req, result] : done)
+				{
+					if (result < 0)
+					{
+						LOG_ERROR(GENERAL, "AIO: %s of 0x%llx bytes at 0x%llx failed (errno=%d)", req.is_write ? "Write" : "Read", req.size, req.offset, -result);
+					}
+
+					req.callback(result < 0 ? UINT64_MAX : result);
+				}
+
+				done.clear();
+
+				if (stop)
+				{
+					return;
+				}
+			}
+		}
+	};
+#else
+	struct aio_engine::uring
+	{
+		static bool accepts(const request&)
+		{
+			return false;
+		}
+
+		void submit(std::vector<request>&&)
+		{
+		}
+
+		bool cancel(u64, request&)
+		{
+			return false;
+		}
+	};
+#endif
+
+	aio_engine::aio_engine(u32 max_threads)
+	{
+#ifdef AIO_HAS_URING
+		m_uring = std::make_unique<uring>();
+
+		if (const int error = m_uring->init())
+		{
+			LOG_NOTICE(GENERAL, "AIO: io_uring is not available (errno=%d), using worker threads", error);
+			m_uring.reset();
+		}
+#endif
+
+		const u32 num_threads = max_threads ? max_threads : std::clamp<u32>(std::thread::hardware_concurrency() / 2, 2, 4);
+
+		for (u32 i = 0; i < num_threads; i++)
+		{
+			m_workers.emplace_back(fmt::format("FS AIO Worker %u", i), [this] { worker(); });
+		}
+	}
+
+	aio_engine::~aio_engine()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_stop = true;
+		}
+
+		// Workers finish the queue before exiting
+		m_cv.notify_all();
+		m_workers.clear();
+
+		m_uring.reset();
+	}
+
+	void aio_engine::submit(std::vector<request>&& requests)
+	{
+		std::vector<request> kernel_requests;
+		u32 count = 0;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			for (auto& req : requests)
+			{
+				if (m_uring && uring::accepts(req))
+				{
+					kernel_requests.emplace_back(std::move(req));
+					continue;
+				}
+
+				m_queue.emplace_back(std::move(req));
+				count++;
+			}
+		}
+
+		if (count == 1)
+		{
+			m_cv.notify_one();
+		}
+		else if (count)
+		{
+			m_cv.notify_all();
+		}
+
+		if (!kernel_requests.empty())
+		{
+			m_uring->submit(std::move(kernel_requests));
+		}
+	}
+
+	bool aio_engine::cancel(u64 id)
+	{
+		if (!id)
+		{
+			return false;
+		}
+
+		request req;
+		bool found = false;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			const auto it = std::find_if(m_queue.begin(), m_queue.end(), [&](const request& r) { return r.id == id; });
+
+			if (it != m_queue.end())
+			{
+				req = std::move(*it);
+				m_queue.erase(it);
+				found = true;
+			}
+		}
+
+		if (!found && m_uring)
+		{
+			found = m_uring->cancel(id, req);
+		}
+
+		if (!found)
+		{
+			return false;
+		}
+
+		req.callback(canceled);
+		return true;
+	}
+
+	void aio_engine::worker()
+	{
+		std::unique_lock lock(m_mutex);
+
+		while (true)
+		{
+			m_cv.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+
+			if (m_queue.empty())
+			{
+				return;
+			}
+
+			request req = std::move(m_queue.front());
+			m_queue.pop_front();
+			lock.unlock();
+
+			const u64 result = req.is_write
+				? req.handle->write_at(req.offset, req.buffer, req.size)
+				: req.handle->read_at(req.offset, req.buffer, req.size);
+
+			req.callback(result);
+			req = {};
+
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "types.h"
+#include "File.h"
+#include "Thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fs
+{
+	// Asynchronous positional file I/O.
+	// Native files are read and written through io_uring on Linux if the kernel supports it.
+	// Everything else is done by a pool of worker threads with file::read_at() and file::write_at().
+	class aio_engine
+	{
+	public:
+		struct request
+		{
+			// Keeps the file open until the request is completed
+			std::shared_ptr<const file> handle;
+
+			u64 offset = 0;
+			void* buffer = nullptr;
+			u64 size = 0;
+			bool is_write = false;
+
+			// Nonzero to allow cancel() to find the request
+			u64 id = 0;
+
+			// Called on an internal thread with the amount of data transferred, UINT64_MAX on error, or canceled
+			std::function<void(u64)> callback;
+		};
+
+		// Result passed to the callback of a request removed by cancel()
+		static constexpr u64 canceled = UINT64_MAX - 1;
+
+	private:
+		// Kernel interface (io_uring)
+		struct uring;
+
+		std::unique_ptr<uring> m_uring;
+
+		// Requests for the worker threads
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<request> m_queue;
+		bool m_stop = false;
+
+		std::deque<named_thread<std::function<void()>>> m_workers;
+
+		void worker();
+
+	public:
+		// Worker threads are started immediately, max_threads = 0 chooses their number
+		explicit aio_engine(u32 max_threads = 0);
+
+		aio_engine(const aio_engine&) = delete;
+
+		aio_engine& operator=(const aio_engine&) = delete;
+
+		// Waits for the pending requests
+		~aio_engine();
+
+		// Queue the requests (with a single system call if possible), they may complete in any order
+		void submit(std::vector<request>&& requests);
+
+		// Remove a request which hasn't been started yet and call its callback on this thread with canceled
+		bool cancel(u64 id);
+
+		bool is_kernel_backed() const
+		{
+			return m_uring != nullptr;
+		}
+	};
+}
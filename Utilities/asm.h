@@ -69,6 +69,11 @@ namespace utils
 #endif
 	}
 
+	inline u8 popcnt64(u64 arg)
+	{
+		return popcnt32(static_cast<u32>(arg)) + popcnt32(static_cast<u32>(arg >> 32));
+	}
+
 // Rotate helpers
 #if defined(__GNUG__)
 
@@ -31,10 +31,16 @@ namespace utils
 
 	bool has_sse41();
 
+	bool has_sse42();
+
 	bool has_avx();
 
 	bool has_avx2();
 
+	bool has_aes();
+
+	bool has_sha();
+
 	bool has_rtm();
 
 	bool has_tsx_force_abort();
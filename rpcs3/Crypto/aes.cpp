@@ -30,6 +30,88 @@
  */
 
 #include "aes.h"
+#include "../../Utilities/sysinfo.h"
+
+#if defined(_MSC_VER) || defined(__AES__)
+#include <wmmintrin.h>
+#define POLARSSL_HAVE_AESNI
+#endif
+
+/*
+ * AES-NI is used when the CPU supports it (checked at runtime with MSVC,
+ * at compile time with other compilers)
+ */
+static const bool aesni_supported =
+#if !defined(POLARSSL_HAVE_AESNI)
+    false;
+#elif defined(_MSC_VER)
+    utils::has_aes();
+#else
+    true;
+#endif
+
+static bool aesni_enabled = aesni_supported;
+
+int aes_set_hw_acceleration( int enable )
+{
+    aesni_enabled = aesni_supported && enable;
+    return( aesni_enabled );
+}
+
+#if defined(POLARSSL_HAVE_AESNI)
+
+/*
+ * Encrypt or decrypt N independent blocks, interleaved to hide the latency of AESENC/AESDEC.
+ * The round keys generated by aes_setkey_enc/aes_setkey_dec are already in the layout
+ * AES-NI expects (decryption keys are the InvMixColumns-transformed keys of the equivalent inverse cipher).
+ */
+template <size_t N>
+static inline void aesni_crypt_blocks( const aes_context *ctx, int mode, __m128i (&blocks)[N] )
+{
+    const __m128i *rk = reinterpret_cast<const __m128i*>( ctx->rk );
+    __m128i key = _mm_loadu_si128( rk );
+
+    for( size_t i = 0; i < N; i++ )
+        blocks[i] = _mm_xor_si128( blocks[i], key );
+
+    if( mode == AES_DECRYPT )
+    {
+        for( int r = 1; r < ctx->nr; r++ )
+        {
+            key = _mm_loadu_si128( rk + r );
+
+            for( size_t i = 0; i < N; i++ )
+                blocks[i] = _mm_aesdec_si128( blocks[i], key );
+        }
+
+        key = _mm_loadu_si128( rk + ctx->nr );
+
+        for( size_t i = 0; i < N; i++ )
+            blocks[i] = _mm_aesdeclast_si128( blocks[i], key );
+    }
+    else
+    {
+        for( int r = 1; r < ctx->nr; r++ )
+        {
+            key = _mm_loadu_si128( rk + r );
+
+            for( size_t i = 0; i < N; i++ )
+                blocks[i] = _mm_aesenc_si128( blocks[i], key );
+        }
+
+        key = _mm_loadu_si128( rk + ctx->nr );
+
+        for( size_t i = 0; i < N; i++ )
+            blocks[i] = _mm_aesenclast_si128( blocks[i], key );
+    }
+}
+
+/*
+ * Number of blocks processed together in CBC decryption and CTR mode
+ */
+#define AESNI_PARALLEL_BLOCKS 8
+
+#endif
 
 /*
  * 32-bit integer manipulation macros (little endian)
@@ -643,6 +725,16 @@ int aes_crypt_ecb( aes_context *ctx,
     int i;
     uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+#if defined(POLARSSL_HAVE_AESNI)
+    if( aesni_enabled )
+    {
+        __m128i block[1] = { _mm_loadu_si128( reinterpret_cast<const __m128i*>( input ) ) };
+        aesni_crypt_blocks( ctx, mode, block );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( output ), block[0] );
+        return( 0 );
+    }
+#endif
+
     RK = ctx->rk;
 
     GET_UINT32_LE( X0, input,  0 ); X0 ^= *RK++;
@@ -743,6 +835,35 @@ int aes_crypt_cbc( aes_context *ctx,
     if( length % 16 )
         return( POLARSSL_ERR_AES_INVALID_INPUT_LENGTH );
 
+#if defined(POLARSSL_HAVE_AESNI)
+    if( aesni_enabled && mode == AES_DECRYPT )
+    {
+        // Unlike encryption, CBC decryption of consecutive blocks is independent
+        __m128i prev = _mm_loadu_si128( reinterpret_cast<const __m128i*>( iv ) );
+
+        for( ; length >= 16 * AESNI_PARALLEL_BLOCKS; length -= 16 * AESNI_PARALLEL_BLOCKS )
+        {
+            __m128i cipher[AESNI_PARALLEL_BLOCKS], blocks[AESNI_PARALLEL_BLOCKS];
+
+            for( i = 0; i < AESNI_PARALLEL_BLOCKS; i++ )
+                blocks[i] = cipher[i] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input ) + i );
+
+            aesni_crypt_blocks( ctx, mode, blocks );
+
+            for( i = 0; i < AESNI_PARALLEL_BLOCKS; i++ )
+            {
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( output ) + i, _mm_xor_si128( blocks[i], prev ) );
+                prev = cipher[i];
+            }
+
+            input  += 16 * AESNI_PARALLEL_BLOCKS;
+            output += 16 * AESNI_PARALLEL_BLOCKS;
+        }
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( iv ), prev );
+    }
+#endif
+
     if( mode == AES_DECRYPT )
     {
         while( length > 0 )
@@ -839,6 +960,39 @@ int aes_crypt_ctr( aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+#if defined(POLARSSL_HAVE_AESNI)
+    if( aesni_enabled && n == 0 )
+    {
+        for( ; length >= 16 * AESNI_PARALLEL_BLOCKS; length -= 16 * AESNI_PARALLEL_BLOCKS )
+        {
+            __m128i blocks[AESNI_PARALLEL_BLOCKS];
+
+            for( size_t b = 0; b < AESNI_PARALLEL_BLOCKS; b++ )
+            {
+                blocks[b] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( nonce_counter ) );
+
+                // 128-bit big endian increment
+                for( i = 16; i > 0; i-- )
+                    if( ++nonce_counter[i - 1] != 0 )
+                        break;
+            }
+
+            aesni_crypt_blocks( ctx, AES_ENCRYPT, blocks );
+
+            for( size_t b = 0; b < AESNI_PARALLEL_BLOCKS; b++ )
+            {
+                const __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input ) + b );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( output ) + b, _mm_xor_si128( data, blocks[b] ) );
+            }
+
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( stream_block ), blocks[AESNI_PARALLEL_BLOCKS - 1] );
+
+            input  += 16 * AESNI_PARALLEL_BLOCKS;
+            output += 16 * AESNI_PARALLEL_BLOCKS;
+        }
+    }
+#endif
+
     while( length-- )
     {
         if( n == 0 ) {
@@ -174,6 +174,15 @@ int aes_crypt_ctr( aes_context *ctx,
 
 void aes_cmac(aes_context *ctx, int length, unsigned char *input, unsigned char *output);
 
+/**
+ * \brief          Enable or disable AES-NI, if the CPU supports it (enabled by default)
+ *
+ * \param enable   0 to force the table-based implementation
+ *
+ * \return         1 if AES-NI is used after the call, 0 otherwise
+ */
+int aes_set_hw_acceleration( int enable );
+
 #ifdef __cplusplus
 }
 #endif
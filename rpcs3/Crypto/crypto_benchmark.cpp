@@ -0,0 +1,142 @@
+#include "stdafx.h"
+#include "crypto_benchmark.h"
+#include "aes.h"
+#include "sha1.h"
+#include "Utilities/Timer.h"
+
+#include <cstdio>
+
+namespace
+{
+	// Minimum wall time spent on each case
+	constexpr u64 min_case_duration_us = 100'000;
+	constexpr u32 min_case_iterations = 3;
+
+	// Large enough to leave the caches like a package install does
+	constexpr u32 buffer_size = 16 * 1024 * 1024;
+
+	// Runs func until enough time has elapsed, func processes the whole buffer
+	template <typename F>
+	void run_case(const std::string& filter, const std::string& name, F&& func)
+	{
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+		{
+			return;
+		}
+
+		u32 iterations = 0;
+
+		Timer timer;
+		timer.Start();
+
+		do
+		{
+			func();
+			iterations++;
+		}
+		while (iterations < min_case_iterations || timer.GetElapsedTimeInMicroSec() < min_case_duration_us);
+
+		// Bytes per microsecond is MB/s
+		const u64 elapsed_us = std::max<u64>(timer.GetElapsedTimeInMicroSec(), 1);
+		std::printf("%-40s %12.1f MB/s\n", name.c_str(), double(buffer_size) * iterations / elapsed_us);
+		std::fflush(stdout);
+	}
+}
+
+void run_crypto_benchmark(const std::string& filter)
+{
+	std::vector<u8> src(buffer_size), dst(buffer_size);
+
+	for (u32 i = 0; i < buffer_size; i++)
+	{
+		src[i] = static_cast<u8>(i * 0x9e3779b1 >> 24);
+	}
+
+	const u8 key[32] = { 0x2e, 0x7b, 0x71, 0xd7, 0xc9, 0xc9, 0xa1, 0x4e, 0xa3, 0x22, 0x1f, 0x18, 0x88, 0x28, 0xb8, 0xf8, 0x17, 0x4a, 0x3c, 0x05 };
+
+	const bool has_aesni = aes_set_hw_acceleration(1) != 0;
+	const bool has_shani = sha1_set_hw_acceleration(1) != 0;
+
+	std::printf("AES-NI: %s, SHA extensions: %s\n", has_aesni ? "yes" : "no", has_shani ? "yes" : "no");
+
+	for (const bool hw : { false, true })
+	{
+		if (hw && !has_aesni && !has_shani)
+		{
+			break;
+		}
+
+		aes_set_hw_acceleration(hw);
+		sha1_set_hw_acceleration(hw);
+
+		const std::string suffix = hw ? ".hw" : ".soft";
+
+		if (!hw || has_aesni)
+		{
+			for (const u32 key_bits : { 128u, 256u })
+			{
+				const std::string prefix = fmt::format("aes%u.", key_bits);
+
+				aes_context enc, dec;
+				aes_setkey_enc(&enc, key, key_bits);
+				aes_setkey_dec(&dec, key, key_bits);
+
+				run_case(filter, prefix + "ecb.decrypt" + suffix, [&]
+				{
+					for (u32 i = 0; i < buffer_size; i += 16)
+					{
+						aes_crypt_ecb(&dec, AES_DECRYPT, src.data() + i, dst.data() + i);
+					}
+				});
+
+				run_case(filter, prefix + "cbc.encrypt" + suffix, [&]
+				{
+					u8 iv[16]{};
+					aes_crypt_cbc(&enc, AES_ENCRYPT, buffer_size, iv, src.data(), dst.data());
+				});
+
+				run_case(filter, prefix + "cbc.decrypt" + suffix, [&]
+				{
+					u8 iv[16]{};
+					aes_crypt_cbc(&dec, AES_DECRYPT, buffer_size, iv, src.data(), dst.data());
+				});
+
+				run_case(filter, prefix + "ctr" + suffix, [&]
+				{
+					u8 counter[16]{}, stream[16];
+					size_t offset = 0;
+					aes_crypt_ctr(&enc, buffer_size, &offset, counter, stream, src.data(), dst.data());
+				});
+			}
+		}
+
+		if (!hw || has_shani)
+		{
+			run_case(filter, "sha1" + suffix, [&]
+			{
+				u8 digest[20];
+				sha1(src.data(), buffer_size, digest);
+			});
+
+			// Debug packages hash every 16-byte block separately
+			run_case(filter, "sha1.16b" + suffix, [&]
+			{
+				u8 digest[20];
+
+				for (u32 i = 0; i < buffer_size; i += 16)
+				{
+					sha1(src.data() + i, 16, digest);
+				}
+			});
+
+			run_case(filter, "sha1.hmac" + suffix, [&]
+			{
+				u8 digest[20];
+				sha1_hmac(key, 20, src.data(), buffer_size, digest);
+			});
+		}
+	}
+
+	aes_set_hw_acceleration(1);
+	sha1_set_hw_acceleration(1);
+}
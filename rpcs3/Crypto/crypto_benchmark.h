@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Utilities/types.h"
+
+#include <string>
+
+/**
+ * Measures the throughput of the AES modes and SHA-1 variants used by the PKG, SELF and EDAT decrypters.
+ * Every case is run with the portable implementation and, if the CPU supports it, with AES-NI or the SHA extensions.
+ * Results are printed to stdout in MB/s. Only cases whose name contains filter are run; an empty filter runs everything.
+ */
+void run_crypto_benchmark(const std::string& filter);
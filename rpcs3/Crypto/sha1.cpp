@@ -29,6 +29,134 @@
  */
  
 #include "sha1.h"
+#include "../../Utilities/sysinfo.h"
+
+#if defined(_MSC_VER) || (defined(__SHA__) && defined(__SSE4_1__))
+#include <immintrin.h>
+#define POLARSSL_HAVE_SHANI
+#endif
+
+/*
+ * SHA extensions are used when the CPU supports them (checked at runtime with MSVC,
+ * at compile time with other compilers)
+ */
+static const bool shani_supported =
+#if !defined(POLARSSL_HAVE_SHANI)
+    false;
+#elif defined(_MSC_VER)
+    utils::has_sha() && utils::has_sse41();
+#else
+    true;
+#endif
+
+static bool shani_enabled = shani_supported;
+
+int sha1_set_hw_acceleration( int enable )
+{
+    shani_enabled = shani_supported && enable;
+    return( shani_enabled );
+}
+
+#if defined(POLARSSL_HAVE_SHANI)
+
+/*
+ * Four rounds using the message words in MSG, E0 and E1 alternate between
+ * holding the E input of the current and the next group of rounds
+ */
+#define SHANI_ROUNDS(E_CUR, E_NEXT, MSG, FUNC)          \
+{                                                       \
+    E_CUR  = _mm_sha1nexte_epu32( E_CUR, MSG );         \
+    E_NEXT = ABCD;                                      \
+    ABCD   = _mm_sha1rnds4_epu32( ABCD, E_CUR, FUNC );  \
+}
+
+/*
+ * SHA-1 process buffer of whole blocks with the SHA extensions
+ */
+static void sha1_process_shani( uint32_t state[5], const unsigned char *data, size_t blocks )
+{
+    const __m128i MASK = _mm_set_epi64x( 0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL );
+
+    __m128i ABCD = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( state ) ), 0x1B );
+    __m128i E0 = _mm_set_epi32( state[4], 0, 0, 0 );
+    __m128i E1, MSG0, MSG1, MSG2, MSG3;
+
+#if defined(__AVX__)
+    /* The SHA instructions have no VEX encoding: avoid the SSE/AVX transition penalty */
+    _mm256_zeroupper();
+#endif
+
+    for( ; blocks; blocks--, data += 64 )
+    {
+        const __m128i ABCD_SAVE = ABCD;
+        const __m128i E0_SAVE = E0;
+
+        MSG0 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( data +  0 ) ), MASK );
+        MSG1 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + 16 ) ), MASK );
+        MSG2 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + 32 ) ), MASK );
+        MSG3 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + 48 ) ), MASK );
+
+        /* Rounds 0-3 */
+        E0   = _mm_add_epi32( E0, MSG0 );
+        E1   = ABCD;
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+
+        /* Rounds 4-15 */
+        SHANI_ROUNDS( E1, E0, MSG1, 0 );
+        MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+        SHANI_ROUNDS( E0, E1, MSG2, 0 );
+        MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+        MSG0 = _mm_xor_si128( MSG0, MSG2 );
+        MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+        SHANI_ROUNDS( E1, E0, MSG3, 0 );
+        MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+        MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+        /* Rounds 16-63: schedule the next message words while hashing the current ones */
+#define SHANI_ROUNDS_SCHEDULE(E_CUR, E_NEXT, M0, M1, M2, M3, FUNC) \
+        M1 = _mm_sha1msg2_epu32( M1, M0 );              \
+        SHANI_ROUNDS( E_CUR, E_NEXT, M0, FUNC );        \
+        M3 = _mm_sha1msg1_epu32( M3, M0 );              \
+        M2 = _mm_xor_si128( M2, M0 );
+
+        SHANI_ROUNDS_SCHEDULE( E0, E1, MSG0, MSG1, MSG2, MSG3, 0 );
+        SHANI_ROUNDS_SCHEDULE( E1, E0, MSG1, MSG2, MSG3, MSG0, 1 );
+        SHANI_ROUNDS_SCHEDULE( E0, E1, MSG2, MSG3, MSG0, MSG1, 1 );
+        SHANI_ROUNDS_SCHEDULE( E1, E0, MSG3, MSG0, MSG1, MSG2, 1 );
+        SHANI_ROUNDS_SCHEDULE( E0, E1, MSG0, MSG1, MSG2, MSG3, 1 );
+        SHANI_ROUNDS_SCHEDULE( E1, E0, MSG1, MSG2, MSG3, MSG0, 1 );
+        SHANI_ROUNDS_SCHEDULE( E0, E1, MSG2, MSG3, MSG0, MSG1, 2 );
+        SHANI_ROUNDS_SCHEDULE( E1, E0, MSG3, MSG0, MSG1, MSG2, 2 );
+        SHANI_ROUNDS_SCHEDULE( E0, E1, MSG0, MSG1, MSG2, MSG3, 2 );
+        SHANI_ROUNDS_SCHEDULE( E1, E0, MSG1, MSG2, MSG3, MSG0, 2 );
+        SHANI_ROUNDS_SCHEDULE( E0, E1, MSG2, MSG3, MSG0, MSG1, 2 );
+        SHANI_ROUNDS_SCHEDULE( E1, E0, MSG3, MSG0, MSG1, MSG2, 3 );
+#undef SHANI_ROUNDS_SCHEDULE
+
+        /* Rounds 64-79 */
+        MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+        SHANI_ROUNDS( E0, E1, MSG0, 3 );
+        MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+        MSG2 = _mm_xor_si128( MSG2, MSG0 );
+        MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+        SHANI_ROUNDS( E1, E0, MSG1, 3 );
+        MSG3 = _mm_xor_si128( MSG3, MSG1 );
+        MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+        SHANI_ROUNDS( E0, E1, MSG2, 3 );
+        SHANI_ROUNDS( E1, E0, MSG3, 3 );
+
+        /* Combine state */
+        E0   = _mm_sha1nexte_epu32( E0, E0_SAVE );
+        ABCD = _mm_add_epi32( ABCD, ABCD_SAVE );
+    }
+
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( state ), _mm_shuffle_epi32( ABCD, 0x1B ) );
+    state[4] = _mm_extract_epi32( E0, 3 );
+}
+
+#undef SHANI_ROUNDS
+
+#endif
 
 /*
  * 32-bit integer manipulation macros (big endian)
@@ -72,6 +200,14 @@ void sha1_process( sha1_context *ctx, const unsigned char data[64] )
 {
     uint32_t temp, W[16], A, B, C, D, E;
 
+#if defined(POLARSSL_HAVE_SHANI)
+    if( shani_enabled )
+    {
+        sha1_process_shani( ctx->state, data, 1 );
+        return;
+    }
+#endif
+
     GET_UINT32_BE( W[ 0], data,  0 );
     GET_UINT32_BE( W[ 1], data,  4 );
     GET_UINT32_BE( W[ 2], data,  8 );
@@ -254,6 +390,15 @@ void sha1_update( sha1_context *ctx, const unsigned char *input, size_t ilen )
         left = 0;
     }
 
+#if defined(POLARSSL_HAVE_SHANI)
+    if( shani_enabled && ilen >= 64 )
+    {
+        sha1_process_shani( ctx->state, input, ilen / 64 );
+        input += ilen & ~(size_t)63;
+        ilen  &= 63;
+    }
+#endif
+
     while( ilen >= 64 )
     {
         sha1_process( ctx, input );
@@ -85,6 +85,15 @@ void sha1_finish( sha1_context *ctx, unsigned char output[20] );
 /* Internal use */
 void sha1_process( sha1_context *ctx, const unsigned char data[64] );
 
+/**
+ * \brief          Enable or disable the SHA extensions, if the CPU supports them (enabled by default)
+ *
+ * \param enable   0 to force the portable implementation
+ *
+ * \return         1 if the SHA extensions are used after the call, 0 otherwise
+ */
+int sha1_set_hw_acceleration( int enable );
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,8 +1,11 @@
 #include "stdafx.h"
 #include "key_vault.h"
 #include "unedat.h"
+#include "Utilities/Thread.h"
 
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 
 void generate_key(int crypto_mode, int version, unsigned char *key_final, unsigned char *iv_final, unsigned char *key, unsigned char *iv)
 {
@@ -144,7 +147,8 @@ std::array<u8, 0x10> get_block_key(int block, NPD_HEADER *npd)
 // for out data, allocate a buffer the size of 'edat->block_size'
 // Also, set 'in file' to the beginning of the encrypted data, which may be offset if inside another file, but normally just reset to beginning of file
 // returns number of bytes written, -1 for error
-s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *npd, u8* crypt_key, u32 block_num, u32 total_blocks, u64 size_left)
+// If input_lock is set, it's released once the encrypted data has been read
+s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *npd, u8* crypt_key, u32 block_num, u32 total_blocks, u64 size_left, std::unique_lock<std::mutex>* input_lock = nullptr)
 {
 	// Get metadata info and setup buffers.
 	const int metadata_section_size = ((edat->flags & EDAT_COMPRESSED_FLAG) != 0 || (edat->flags & EDAT_FLAG_0x20) != 0) ? 0x20 : 0x10;
@@ -238,6 +242,11 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	in->seek(file_offset + offset);
 	in->read(enc_data.get(), length);
 
+	if (input_lock)
+	{
+		input_lock->unlock();
+	}
+
 	// Generate a key for the current block.
 	std::array<u8, 0x10> b_key = get_block_key(block_num, npd);
 
@@ -940,40 +949,211 @@ bool EDATADecrypter::ReadHeader()
 	return true;
 }
 
-u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
+namespace
 {
-	if (pos > edatHeader.file_size)
-		return 0;
+	// Decrypts the blocks following sequential EDATA reads in the background
+	struct edata_readahead_thread
+	{
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<std::pair<EDATADecrypter*, u32>> queue;
+		EDATADecrypter* current = nullptr;
+		bool started = false;
 
-	// now we need to offset things to account for the actual 'range' requested
-	const u64 startOffset = pos % edatHeader.block_size;
+		void run()
+		{
+			std::unique_lock lock(mutex);
+
+			while (true)
+			{
+				cv.wait(lock, [&] { return !queue.empty(); });
+
+				const auto [file, block] = queue.front();
+				queue.pop_front();
+				current = file;
+
+				lock.unlock();
+				file->PrefetchBlock(block);
+				lock.lock();
+
+				current = nullptr;
+				cv.notify_all();
+			}
+		}
+
+		void push(EDATADecrypter* file, u32 block)
+		{
+			std::lock_guard lock(mutex);
+
+			if (!started)
+			{
+				started = true;
+				thread_ctrl::spawn("EDATA Read-ahead", [this]() { run(); });
+			}
+
+			queue.emplace_back(file, block);
+			cv.notify_all();
+		}
+
+		// Forget the pending requests of the file and wait until it's not being processed
+		void cancel(EDATADecrypter* file)
+		{
+			std::unique_lock lock(mutex);
+
+			queue.erase(std::remove_if(queue.begin(), queue.end(), [&](const auto& request) { return request.first == file; }), queue.end());
 
-	const u32 num_blocks = static_cast<u32>(std::ceil((startOffset + size) / (double)edatHeader.block_size));
-	const u64 bufSize = num_blocks*edatHeader.block_size;
-	if (data_buf_size < (bufSize))
+			cv.wait(lock, [&] { return current != file; });
+		}
+	};
+
+	// Never destroyed, the thread is never joined
+	edata_readahead_thread& get_readahead_thread()
 	{
-		data_buf.reset(new u8[bufSize]);
-		data_buf_size = bufSize;
+		static edata_readahead_thread* const instance = new edata_readahead_thread();
+		return *instance;
 	}
+}
 
-	// find and decrypt block range covering pos + size
-	const u32 starting_block = static_cast<u32>(pos / edatHeader.block_size);
-	const u32 ending_block = std::min(starting_block + num_blocks, total_blocks);
-	u64 writeOffset = 0;
-	for (u32 i = starting_block; i < ending_block; ++i)
+EDATADecrypter::~EDATADecrypter()
+{
+	get_readahead_thread().cancel(this);
+}
+
+const EDATADecrypter::cached_block* EDATADecrypter::GetBlock(u32 block, std::unique_lock<std::mutex>& lock)
+{
+	for (auto found = block_cache.find(block); found != block_cache.end(); found = block_cache.find(block))
+	{
+		if (!found->second.in_flight)
+		{
+			found->second.last_use = ++cache_clock;
+			return &found->second;
+		}
+
+		cache_cv.wait(lock);
+	}
+
+	std::unique_ptr<u8[]> buffer;
+
+	// Reuse the buffer of the least recently used block (blocks being decrypted can't be replaced)
+	auto lru = block_cache.end();
+
+	if (block_cache.size() >= max_cached_blocks)
+	{
+		for (auto it = block_cache.begin(); it != block_cache.end(); ++it)
+		{
+			if (!it->second.in_flight && (lru == block_cache.end() || it->second.last_use < lru->second.last_use))
+			{
+				lru = it;
+			}
+		}
+	}
+
+	if (lru != block_cache.end())
 	{
+		buffer = std::move(lru->second.data);
+		block_cache.erase(lru);
+	}
+	else
+	{
+		buffer.reset(new u8[edatHeader.block_size]);
+	}
+
+	block_cache[block].in_flight = true;
+	lock.unlock();
+
+	s64 res;
+	{
+		std::unique_lock file_lock(file_mutex);
 		edata_file.seek(0);
-		u64 res = decrypt_block(&edata_file, &data_buf[writeOffset], &edatHeader, &npdHeader, dec_key.data(), i, total_blocks, edatHeader.file_size);
-		if (res == -1)
+		res = decrypt_block(&edata_file, buffer.get(), &edatHeader, &npdHeader, dec_key.data(), block, total_blocks, edatHeader.file_size, &file_lock);
+	}
+
+	lock.lock();
+	cache_cv.notify_all();
+
+	if (res == -1)
+	{
+		block_cache.erase(block);
+		return nullptr;
+	}
+
+	auto& cached = block_cache[block];
+	cached.data = std::move(buffer);
+	cached.size = res;
+	cached.last_use = ++cache_clock;
+	cached.in_flight = false;
+	return &cached;
+}
+
+void EDATADecrypter::PrefetchBlock(u32 block)
+{
+	std::unique_lock lock(cache_mutex);
+
+	// Skip blocks that are already cached or being decrypted by a reader
+	if (block < total_blocks && !block_cache.count(block))
+	{
+		GetBlock(block, lock);
+	}
+}
+
+u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
+{
+	if (size == 0 || pos > edatHeader.file_size)
+		return 0;
+
+	std::unique_lock lock(cache_mutex);
+
+	// now we need to offset things to account for the actual 'range' requested
+	u64 startOffset = pos % edatHeader.block_size;
+
+	// copy from the blocks covering pos + size
+	const u32 starting_block = static_cast<u32>(pos / edatHeader.block_size);
+	u64 bytesWrote = 0;
+	u32 i = starting_block;
+
+	for (; i < total_blocks && bytesWrote < size; ++i)
+	{
+		const cached_block* block = GetBlock(i, lock);
+
+		if (!block)
 		{
 			LOG_ERROR(LOADER, "Error Decrypting data");
 			return 0;
 		}
-		writeOffset += res;
+
+		if (block->size <= startOffset)
+		{
+			break;
+		}
+
+		const u64 count = std::min<u64>(block->size - startOffset, size - bytesWrote);
+		memcpy(data + bytesWrote, &block->data[startOffset], count);
+		bytesWrote += count;
+		startOffset = 0;
+	}
+
+	// Small records are usually read sequentially, in this case decrypt the next blocks in advance
+	const bool sequential = starting_block == last_block || starting_block == last_block + 1;
+	last_block = i - 1;
+
+	if (!sequential)
+	{
+		readahead_end = 0;
 	}
+	else if (i < total_blocks)
+	{
+		const u32 end = std::min(i + readahead_blocks, total_blocks);
 
-	const u64 bytesWrote = std::min<u64>(writeOffset - startOffset, size);
+		for (u32 block = std::max(i, readahead_end); block < end; block++)
+		{
+			if (!block_cache.count(block))
+			{
+				get_readahead_thread().push(this, block);
+			}
+		}
+
+		readahead_end = std::max(readahead_end, end);
+	}
 
-	memcpy(data, &data_buf[startOffset], bytesWrote);
 	return bytesWrote;
 }
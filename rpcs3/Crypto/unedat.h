@@ -1,6 +1,9 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
 
 #include "utils.h"
 
@@ -59,9 +62,32 @@ struct EDATADecrypter final : fs::file_base
 	NPD_HEADER npdHeader;
 	EDAT_HEADER edatHeader;
 
-	// Internal data buffers.
-	std::unique_ptr<u8[]> data_buf;
-	u64 data_buf_size{0};
+	// Decrypted blocks, the least recently used one is replaced when the cache is full
+	struct cached_block
+	{
+		std::unique_ptr<u8[]> data;
+		u64 size{0};
+		u64 last_use{0};
+
+		// Set while a thread decrypts the block, other threads wait for it instead of decrypting it again
+		bool in_flight{false};
+	};
+
+	static constexpr u32 max_cached_blocks = 16;
+	static constexpr u32 readahead_blocks = 4;
+
+	// Protects the cache, it's not held while blocks are decrypted
+	std::mutex cache_mutex;
+	std::condition_variable cache_cv;
+	std::unordered_map<u32, cached_block> block_cache;
+
+	// Protects the position of edata_file, which is also read by the read-ahead thread
+	std::mutex file_mutex;
+	u64 cache_clock{0};
+
+	// Last block accessed by ReadData and the end of the blocks requested from the read-ahead thread
+	u32 last_block = -1;
+	u32 readahead_end{0};
 
 	std::array<u8, 0x10> dec_key{};
 
@@ -76,11 +102,22 @@ public:
 	EDATADecrypter(fs::file&& input, const std::array<u8, 0x10>& dev_key, const std::array<u8, 0x10>& rif_key)
 		: edata_file(std::move(input)), rif_key(rif_key), dev_key(dev_key) {}
 
-	~EDATADecrypter() override {}
+	~EDATADecrypter() override;
+
 	// false if invalid 
 	bool ReadHeader();
 	u64 ReadData(u64 pos, u8* data, u64 size);
 
+	// Decrypt the block into the cache if it isn't there yet (called by the read-ahead thread)
+	void PrefetchBlock(u32 block);
+
+private:
+	// Get the decrypted block from the cache or decrypt it (nullptr on error)
+	// The lock must own cache_mutex, it's released while decrypting
+	const cached_block* GetBlock(u32 block, std::unique_lock<std::mutex>& lock);
+
+public:
+
 	fs::stat_t stat() override
 	{
 		fs::stat_t stats;
@@ -106,6 +143,14 @@ public:
 	{
 		return 0;
 	}
+	u64 read_at(u64 offset, void* buffer, u64 size) override
+	{
+		return ReadData(offset, static_cast<u8*>(buffer), size);
+	}
+	u64 write_at(u64 offset, const void* buffer, u64 size) override
+	{
+		return 0;
+	}
 
 	u64 seek(s64 offset, fs::seek_mode whence) override
 	{
@@ -6,11 +6,67 @@
 #include "Utilities/StrFmt.h"
 #include "Emu/System.h"
 #include "Emu/VFS.h"
+#include "Utilities/Thread.h"
 #include "unpkg.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Decrypt size bytes of the data area which were read from offset to buf (offset must be a multiple of 16)
+static void pkg_decrypt(const PKGHeader& header, u128* buf, u64 offset, u64 size, const uchar* key)
+{
+	// Get block count
+	const u64 blocks = (size + 15) / 16;
+
+	if (header.pkg_type == PKG_RELEASE_TYPE_DEBUG)
+	{
+		// Debug key
+		be_t<u64> input[8] =
+		{
+			header.qa_digest[0],
+			header.qa_digest[0],
+			header.qa_digest[1],
+			header.qa_digest[1],
+		};
+
+		for (u64 i = 0; i < blocks; i++)
+		{
+			// Initialize stream cipher for current position
+			input[7] = offset / 16 + i;
+
+			union sha1_hash
+			{
+				u8 data[20];
+				u128 _v128;
+			} hash;
+
+			sha1(reinterpret_cast<const u8*>(input), sizeof(input), hash.data);
+
+			buf[i] ^= hash._v128;
+		}
+	}
+
+	if (header.pkg_type == PKG_RELEASE_TYPE_RELEASE)
+	{
+		aes_context ctx;
+
+		// Set encryption key for stream cipher
+		aes_setkey_enc(&ctx, key, 128);
+
+		// Initialize stream cipher for start position, it's incremented as a big endian counter for every block
+		be_t<u128> input = header.klicensee.value() + offset / 16;
+		uchar stream_block[16];
+		size_t stream_offset = 0;
+
+		aes_crypt_ctr(&ctx, blocks * 16, &stream_offset, reinterpret_cast<uchar*>(&input), stream_block, reinterpret_cast<const uchar*>(buf), reinterpret_cast<uchar*>(buf));
+	}
+}
+
 bool pkg_install(const std::string& path, atomic_t<double>& sync)
 {
-	const std::size_t BUF_SIZE = 8192 * 1024; // 8 MB
+	const std::size_t BUF_SIZE = 2048 * 1024; // 2 MB
 
 	std::vector<fs::file> filelist;
 	filelist.emplace_back(fs::file{path});
@@ -227,57 +283,7 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		// Read the data and set available size
 		const u64 read = archive_read(buf.get(), size);
 
-		// Get block count
-		const u64 blocks = (read + 15) / 16;
-
-		if (header.pkg_type == PKG_RELEASE_TYPE_DEBUG)
-		{
-			// Debug key
-			be_t<u64> input[8] =
-			{
-				header.qa_digest[0],
-				header.qa_digest[0],
-				header.qa_digest[1],
-				header.qa_digest[1],
-			};
-
-			for (u64 i = 0; i < blocks; i++)
-			{
-				// Initialize stream cipher for current position
-				input[7] = offset / 16 + i;
-
-				union sha1_hash
-				{
-					u8 data[20];
-					u128 _v128;
-				} hash;
-				
-				sha1(reinterpret_cast<const u8*>(input), sizeof(input), hash.data);
-
-				buf[i] ^= hash._v128;
-			}
-		}
-
-		if (header.pkg_type == PKG_RELEASE_TYPE_RELEASE)
-		{
-			aes_context ctx;
-
-			// Set encryption key for stream cipher
-			aes_setkey_enc(&ctx, key, 128);
-
-			// Initialize stream cipher for start position
-			be_t<u128> input = header.klicensee.value() + offset / 16;
-
-			// Increment stream position for every block
-			for (u64 i = 0; i < blocks; i++, input++)
-			{
-				u128 key;
-
-				aes_crypt_ecb(&ctx, AES_ENCRYPT, reinterpret_cast<const u8*>(&input), reinterpret_cast<u8*>(&key));
-
-				buf[i] ^= key;
-			}
-		}
+		pkg_decrypt(header, buf.get(), offset, read, key);
 
 		// Return the amount of data written in buf
 		return read;
@@ -306,6 +312,20 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 
 	std::memcpy(entries.data(), buf.get(), entries.size() * sizeof(PKGEntry));
 
+	// File extraction job
+	struct install_job
+	{
+		std::string path;
+		std::string name;
+		u64 offset;
+		u64 size;
+		const uchar* key;
+		bool did_overwrite;
+		u32 writer;
+	};
+
+	std::vector<install_job> jobs;
+
 	for (const auto& entry : entries)
 	{
 		const bool is_psp = (entry.type & PKG_FILE_ENTRY_PSP) != 0;
@@ -336,7 +356,7 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		case 0x15:
 		case 0x16:
 		{
-			const std::string path = dir + vfs::escape(name);
+			std::string path = dir + vfs::escape(name);
 
 			const bool did_overwrite = fs::is_file(path);
 
@@ -346,53 +366,8 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 				break;
 			}
 
-			if (fs::file out{path, fs::rewrite})
-			{
-				for (u64 pos = 0; pos < entry.file_size; pos += BUF_SIZE)
-				{
-					const u64 block_size = std::min<u64>(BUF_SIZE, entry.file_size - pos);
-
-					if (decrypt(entry.file_offset + pos, block_size, is_psp ? PKG_AES_KEY2 : dec_key.data()) != block_size)
-					{
-						LOG_ERROR(LOADER, "Failed to extract file %s", path);
-						break;
-					}
-
-					if (out.write(buf.get(), block_size) != block_size)
-					{
-						LOG_ERROR(LOADER, "Failed to write file %s", path);
-						break;
-					}
-
-					if (sync.fetch_add((block_size + 0.0) / header.data_size) < 0.)
-					{
-						if (was_null)
-						{
-							LOG_ERROR(LOADER, "Package installation cancelled: %s", dir);
-							out.close();
-							fs::remove_all(dir, true);
-							return false;
-						}
-
-						// Cannot cancel the installation
-						sync += 1.;
-					}
-				}
-
-				if (did_overwrite)
-				{
-					LOG_WARNING(LOADER, "Overwritten file %s", name);
-				}
-				else
-				{
-					LOG_NOTICE(LOADER, "Created file %s", name);
-				}
-			}
-			else
-			{
-				LOG_ERROR(LOADER, "Failed to create file %s", path);
-			}
-
+			// Extracted after all directories are created
+			jobs.push_back({std::move(path), std::move(name), entry.file_offset, entry.file_size, is_psp ? PKG_AES_KEY2 : dec_key.data(), did_overwrite, 0});
 			break;
 		}
 
@@ -424,6 +399,259 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		}
 	}
 
+	// Extract the files with a pipeline: this thread reads blocks in archive order into a bounded set of buffers,
+	// the workers decrypt them in any order (every cipher block only depends on its offset),
+	// and every writer thread stores the blocks of its own files in order.
+	std::stable_sort(jobs.begin(), jobs.end(), [](const install_job& a, const install_job& b)
+	{
+		return a.offset < b.offset;
+	});
+
+	const u32 num_workers = std::clamp<u32>(std::thread::hardware_concurrency() / 2, 1, 8);
+	const u32 num_writers = std::clamp<u32>(::size32(jobs), 1, 4);
+	const u32 num_blocks = num_workers * 2 + num_writers;
+
+	// Distribute the files between the writers by size
+	{
+		std::vector<u64> writer_load(num_writers);
+
+		for (auto& job : jobs)
+		{
+			job.writer = static_cast<u32>(std::min_element(writer_load.begin(), writer_load.end()) - writer_load.begin());
+			writer_load[job.writer] += job.size + 1;
+		}
+	}
+
+	struct install_block
+	{
+		std::unique_ptr<u128[]> data;
+		u32 job;
+		u64 pos;
+		u64 size;
+		bool read_ok;
+		bool last;
+		bool decrypted;
+	};
+
+	std::vector<install_block> blocks(num_blocks);
+
+	// Pipeline state, protected by the mutex
+	std::mutex mutex;
+	std::condition_variable free_cv, decrypt_cv, write_cv;
+	std::vector<u32> free_blocks;
+	std::deque<u32> decrypt_queue;
+	std::vector<std::deque<u32>> write_queues(num_writers);
+	bool reading_done = false;
+	bool cancelled = false;
+
+	for (u32 i = 0; i < num_blocks; i++)
+	{
+		blocks[i].data.reset(new u128[BUF_SIZE / sizeof(u128)]);
+		free_blocks.push_back(i);
+	}
+
+	// Progress is updated by all writers, cancellation must be seen by exactly one of them
+	std::mutex progress_mutex;
+
+	auto report_progress = [&](u64 size)
+	{
+		std::lock_guard lock(progress_mutex);
+
+		if (sync.fetch_add((size + 0.0) / header.data_size) < 0.)
+		{
+			if (was_null)
+			{
+				std::lock_guard state_lock(mutex);
+				cancelled = true;
+				free_cv.notify_all();
+				return false;
+			}
+
+			// Cannot cancel the installation
+			sync += 1.;
+		}
+
+		return true;
+	};
+
+	std::deque<named_thread<std::function<void()>>> threads;
+
+	for (u32 i = 0; i < num_workers; i++)
+	{
+		threads.emplace_back(fmt::format("PKG Decrypter %u", i), [&]()
+		{
+			std::unique_lock lock(mutex);
+
+			while (true)
+			{
+				decrypt_cv.wait(lock, [&] { return !decrypt_queue.empty() || reading_done; });
+
+				if (decrypt_queue.empty())
+				{
+					break;
+				}
+
+				auto& block = blocks[decrypt_queue.front()];
+				decrypt_queue.pop_front();
+
+				lock.unlock();
+				pkg_decrypt(header, block.data.get(), jobs[block.job].offset + block.pos, block.size, jobs[block.job].key);
+				lock.lock();
+
+				block.decrypted = true;
+				write_cv.notify_all();
+			}
+		});
+	}
+
+	for (u32 i = 0; i < num_writers; i++)
+	{
+		threads.emplace_back(fmt::format("PKG Writer %u", i), [&, i]()
+		{
+			auto& queue = write_queues[i];
+			fs::file out;
+			bool failed = false;
+
+			std::unique_lock lock(mutex);
+
+			while (true)
+			{
+				write_cv.wait(lock, [&] { return (!queue.empty() && blocks[queue.front()].decrypted) || (queue.empty() && reading_done); });
+
+				if (queue.empty())
+				{
+					break;
+				}
+
+				const u32 index = queue.front();
+				queue.pop_front();
+
+				const auto& block = blocks[index];
+				const auto& job = jobs[block.job];
+
+				// Drop the remaining blocks after cancellation
+				const bool skip = cancelled;
+				lock.unlock();
+
+				if (block.pos == 0)
+				{
+					failed = skip;
+
+					if (!failed && !out.open(job.path, fs::rewrite))
+					{
+						LOG_ERROR(LOADER, "Failed to create file %s", job.path);
+						failed = true;
+					}
+				}
+
+				if (failed || skip)
+				{
+					failed = true;
+				}
+				else if (!block.read_ok)
+				{
+					LOG_ERROR(LOADER, "Failed to extract file %s", job.path);
+					failed = true;
+				}
+				else if (out.write(block.data.get(), block.size) != block.size)
+				{
+					LOG_ERROR(LOADER, "Failed to write file %s", job.path);
+					failed = true;
+				}
+				else if (!report_progress(block.size))
+				{
+					failed = true;
+				}
+
+				if (block.last)
+				{
+					out.close();
+
+					if (!failed)
+					{
+						if (job.did_overwrite)
+						{
+							LOG_WARNING(LOADER, "Overwritten file %s", job.name);
+						}
+						else
+						{
+							LOG_NOTICE(LOADER, "Created file %s", job.name);
+						}
+					}
+				}
+
+				lock.lock();
+				free_blocks.push_back(index);
+				free_cv.notify_one();
+			}
+		});
+	}
+
+	// Read the file data
+	for (u32 i = 0; i < jobs.size(); i++)
+	{
+		const auto& job = jobs[i];
+		bool last = false;
+
+		for (u64 pos = 0; !last;)
+		{
+			std::unique_lock lock(mutex);
+
+			free_cv.wait(lock, [&] { return !free_blocks.empty() || cancelled; });
+
+			if (cancelled)
+			{
+				break;
+			}
+
+			const u32 index = free_blocks.back();
+			free_blocks.pop_back();
+			lock.unlock();
+
+			auto& block = blocks[index];
+			block.job = i;
+			block.pos = pos;
+			block.size = std::min<u64>(BUF_SIZE, job.size - pos);
+
+			archive_seek(header.data_offset + job.offset + pos);
+			block.read_ok = archive_read(block.data.get(), block.size) == block.size;
+
+			pos += block.size;
+			block.last = last = !block.read_ok || pos >= job.size;
+
+			// Blocks which failed to read are not decrypted, only reported by the writer
+			block.decrypted = !block.read_ok || block.size == 0;
+
+			lock.lock();
+
+			if (!block.decrypted)
+			{
+				decrypt_queue.push_back(index);
+				decrypt_cv.notify_one();
+			}
+
+			write_queues[job.writer].push_back(index);
+			write_cv.notify_all();
+		}
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		reading_done = true;
+		decrypt_cv.notify_all();
+		write_cv.notify_all();
+	}
+
+	// Wait for the workers and writers
+	threads.clear();
+
+	if (cancelled)
+	{
+		LOG_ERROR(LOADER, "Package installation cancelled: %s", dir);
+		fs::remove_all(dir, true);
+		return false;
+	}
+
 	LOG_SUCCESS(LOADER, "Package successfully installed to %s", dir);
 	return true;
 }
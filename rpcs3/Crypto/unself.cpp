@@ -7,6 +7,7 @@
 #include "Emu/System.h"
 
 #include <algorithm>
+#include <thread>
 #include <zlib.h>
 
 inline u8 Read8(const fs::file& f)
@@ -881,7 +882,6 @@ std::vector<fs::file> SCEDecrypter::MakeFile()
 SELFDecrypter::SELFDecrypter(const fs::file& s)
 	: self_f(s)
 	, key_v()
-	, data_buf_length(0)
 {
 }
 
@@ -1206,66 +1206,40 @@ bool SELFDecrypter::LoadMetadata(u8* klic_key)
 
 bool SELFDecrypter::DecryptData()
 {
-	aes_context aes;
-
-	// Calculate the total data size.
-	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
-	{
-		if (meta_shdr[i].encrypted == 3)
-		{
-			if ((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
-				data_buf_length += meta_shdr[i].data_size;
-		}
-	}
+	// The sections are decrypted one by one when MakeElf writes them (see GetSectionData),
+	// so the sections which aren't program segments are never decrypted.
+	section_buf.clear();
+	return true;
+}
 
-	// Allocate a buffer to store decrypted data.
-	data_buf = std::make_unique<u8[]>(data_buf_length);
+const u8* SELFDecrypter::GetSectionData(u32 index)
+{
+	const auto& section = meta_shdr[index];
 
-	// Set initial offset.
-	u32 data_buf_offset = 0;
+	// Seek to the section data offset and read the data.
+	section_buf.resize(section.data_size);
+	self_f.seek(section.data_offset);
+	self_f.read(section_buf.data(), section.data_size);
 
-	// Parse the metadata section headers to find the offsets of encrypted data.
-	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
+	// Check if this is an encrypted section and make sure the key and iv are not out of boundaries.
+	if (section.encrypted == 3 && (section.key_idx <= meta_hdr.key_count - 1) && (section.iv_idx <= meta_hdr.key_count))
 	{
+		aes_context aes;
 		size_t ctr_nc_off = 0;
-		u8 ctr_stream_block[0x10];
+		u8 ctr_stream_block[0x10]{};
 		u8 data_key[0x10];
 		u8 data_iv[0x10];
 
-		// Check if this is an encrypted section.
-		if (meta_shdr[i].encrypted == 3)
-		{
-			// Make sure the key and iv are not out of boundaries.
-			if((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
-			{
-				// Get the key and iv from the previously stored key buffer.
-				memcpy(data_key, data_keys.get() + meta_shdr[i].key_idx * 0x10, 0x10);
-				memcpy(data_iv, data_keys.get() + meta_shdr[i].iv_idx * 0x10, 0x10);
-
-				// Allocate a buffer to hold the data.
-				auto buf = std::make_unique<u8[]>(meta_shdr[i].data_size);
-
-				// Seek to the section data offset and read the encrypted data.
-				self_f.seek(meta_shdr[i].data_offset);
-				self_f.read(buf.get(), meta_shdr[i].data_size);
+		// Get the key and iv from the previously stored key buffer.
+		memcpy(data_key, data_keys.get() + section.key_idx * 0x10, 0x10);
+		memcpy(data_iv, data_keys.get() + section.iv_idx * 0x10, 0x10);
 
-				// Zero out our ctr nonce.
-				memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
-
-				// Perform AES-CTR encryption on the data blocks.
-				aes_setkey_enc(&aes, data_key, 128);
-				aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, buf.get(), buf.get());
-
-				// Copy the decrypted data.
-				memcpy(data_buf.get() + data_buf_offset, buf.get(), meta_shdr[i].data_size);
-
-				// Advance the buffer's offset.
-				data_buf_offset += meta_shdr[i].data_size;
-			}
-		}
+		// Perform AES-CTR encryption on the data blocks.
+		aes_setkey_enc(&aes, data_key, 128);
+		aes_crypt_ctr(&aes, section.data_size, &ctr_nc_off, data_iv, ctr_stream_block, section_buf.data(), section_buf.data());
 	}
 
-	return true;
+	return section_buf.data();
 }
 
 fs::file SELFDecrypter::MakeElf(bool isElf32)
@@ -1374,6 +1348,71 @@ static bool CheckDebugSelf(fs::file& s)
 	return false;
 }
 
+// Location of the decrypted image in the cache, the key is a digest of the SELF headers (including the metadata and the ELF digest)
+static std::string get_self_cache_path(const fs::file& self, const u8* klic_key)
+{
+	self.seek(0);
+
+	SceHeader hdr;
+	hdr.Load(self);
+
+	const u64 file_size = self.size();
+
+	if (hdr.se_hsize < sizeof(hdr) || hdr.se_hsize > std::min<u64>(file_size, 0x100000))
+	{
+		return {};
+	}
+
+	std::vector<u8> header(hdr.se_hsize);
+	self.seek(0);
+	self.read(header.data(), header.size());
+
+	sha1_context ctx;
+	sha1_starts(&ctx);
+	sha1_update(&ctx, header.data(), header.size());
+	sha1_update(&ctx, reinterpret_cast<const u8*>(&file_size), sizeof(file_size));
+
+	if (klic_key)
+	{
+		sha1_update(&ctx, klic_key, 0x10);
+	}
+
+	u8 digest[20];
+	sha1_finish(&ctx, digest);
+
+	std::string path = fs::get_cache_dir() + "self/";
+
+	for (const u8 byte : digest)
+	{
+		fmt::append(path, "%02x", byte);
+	}
+
+	return path + ".elf";
+}
+
+static void store_self_cache(const std::string& path, const fs::file& elf)
+{
+	// Write to a temporary file first, so an incomplete image is never found
+	const std::string tmp_path = fmt::format("%s.%x.tmp", path, std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	const auto data = elf.to_vector<u8>();
+
+	fs::create_path(fs::get_parent_dir(path));
+
+	if (fs::file tmp{tmp_path, fs::rewrite}; tmp && tmp.write(data.data(), data.size()) == data.size())
+	{
+		tmp.close();
+
+		if (fs::rename(tmp_path, path, true))
+		{
+			return;
+		}
+	}
+
+	LOG_WARNING(LOADER, "SELF: Failed to cache the decrypted image %s (%s)", path, fs::g_tls_error);
+	fs::remove_file(tmp_path);
+}
+
 extern fs::file decrypt_self(fs::file elf_or_self, u8* klic_key)
 {
 	if (!elf_or_self)
@@ -1386,6 +1425,21 @@ extern fs::file decrypt_self(fs::file elf_or_self, u8* klic_key)
 	// Check SELF header first. Check for a debug SELF.
 	if (elf_or_self.size() >= 4 && elf_or_self.read<u32>() == "SCE\0"_u32 && !CheckDebugSelf(elf_or_self))
 	{
+		std::string cache_path;
+
+		// Use the previously decrypted image if available
+		if (g_cfg.vfs.cache_decrypted_self)
+		{
+			cache_path = get_self_cache_path(elf_or_self, klic_key);
+
+			if (fs::file cached{cache_path}; cached && cached.size() >= 4 && cached.read<u32>() == "\177ELF"_u32)
+			{
+				LOG_NOTICE(LOADER, "SELF: Loaded decrypted image from %s", cache_path);
+				cached.seek(0);
+				return cached;
+			}
+		}
+
 		// Check the ELF file class (32 or 64 bit).
 		bool isElf32 = IsSelfElf32(elf_or_self);
 
@@ -1414,7 +1468,14 @@ extern fs::file decrypt_self(fs::file elf_or_self, u8* klic_key)
 		}
 
 		// Make a new ELF file from this SELF.
-		return self_dec.MakeElf(isElf32);
+		fs::file elf = self_dec.MakeElf(isElf32);
+
+		if (!cache_path.empty())
+		{
+			store_self_cache(cache_path, elf);
+		}
+
+		return elf;
 	}
 
 	return elf_or_self;
@@ -404,8 +404,9 @@ class SELFDecrypter
 	// Internal data buffers.
 	std::unique_ptr<u8[]> data_keys;
 	u32 data_keys_length;
-	std::unique_ptr<u8[]> data_buf;
-	u32 data_buf_length;
+
+	// Data of the section being written, segments are only read and decrypted when MakeElf needs them
+	std::vector<u8> section_buf;
 
 	// Main key vault instance.
 	KeyVault key_v;
@@ -421,12 +422,12 @@ public:
 	bool GetKeyFromRap(u8 *content_id, u8 *npdrm_key);
 
 private:
+	// Read the section data into section_buf and decrypt it if necessary
+	const u8* GetSectionData(u32 index);
+
 	template<typename EHdr, typename SHdr, typename PHdr>
 	void WriteElf(fs::file& e, EHdr ehdr, SHdr shdr, PHdr phdr)
 	{
-		// Set initial offset.
-		u32 data_buf_offset = 0;
-
 		// Write ELF header.
 		WriteEhdr(e, ehdr);
 
@@ -441,6 +442,8 @@ private:
 			// PHDR type.
 			if (meta_shdr[i].type == 2)
 			{
+				const u8* data = GetSectionData(i);
+
 				// Decompress if necessary.
 				if (meta_shdr[i].compressed == 2)
 				{
@@ -449,15 +452,11 @@ private:
 					// Create a pointer to a buffer for decompression.
 					std::unique_ptr<u8[]> decomp_buf(new u8[filesz]);
 
-					// Create a buffer separate from data_buf to uncompress.
-					std::unique_ptr<u8[]> zlib_buf(new u8[data_buf_length]);
-					memcpy(zlib_buf.get(), data_buf.get(), data_buf_length);
-
 					uLongf decomp_buf_length = ::narrow<uLongf>(filesz);
 
-					// Use zlib uncompress on the new buffer.
+					// Use zlib uncompress on the section data.
 					// decomp_buf_length changes inside the call to uncompress
-					int rv = uncompress(decomp_buf.get(), &decomp_buf_length, zlib_buf.get() + data_buf_offset, data_buf_length);
+					int rv = uncompress(decomp_buf.get(), &decomp_buf_length, data, meta_shdr[i].data_size);
 
 					// Check for errors (TODO: Probably safe to remove this once these changes have passed testing.)
 					switch (rv)
@@ -476,11 +475,8 @@ private:
 				{
 					// Seek to the program header data offset and write the data.
 					e.seek(phdr[meta_shdr[i].program_idx].p_offset);
-					e.write(data_buf.get() + data_buf_offset, meta_shdr[i].data_size);
+					e.write(data, meta_shdr[i].data_size);
 				}
-
-				// Advance the data buffer offset by data size.
-				data_buf_offset += meta_shdr[i].data_size;
 			}
 		}
 
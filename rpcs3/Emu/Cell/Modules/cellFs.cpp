@@ -4,12 +4,17 @@
 #include "Emu/Cell/PPUModule.h"
 
 #include "Emu/Cell/lv2/sys_fs.h"
+#include "Emu/Cell/lv2/sys_ppu_thread.h"
 #include "Emu/Cell/lv2/sys_sync.h"
 #include "cellFs.h"
+#include "sysPrxForUser.h"
 
 #include "Utilities/StrUtil.h"
+#include "Utilities/aio.h"
 
+#include <deque>
 #include <mutex>
+#include <set>
 
 LOG_CHANNEL(cellFs);
 
@@ -863,78 +868,248 @@ s32 cellFsStReadWaitCallback(u32 fd, u64 size, vm::ptr<void(s32 xfd, u64 xsize)>
 
 using fs_aio_cb_t = vm::ptr<void(vm::ptr<CellFsAio> xaio, s32 error, s32 xid, u64 size)>;
 
-// temporarily
-struct lv2_fs_mount_point
+// Finished request waiting for its callback
+struct fs_aio_completion
 {
-	std::mutex mutex;
+	vm::ptr<CellFsAio> aio;
+	fs_aio_cb_t func;
+	s32 xid;
+	s32 error = CELL_OK;
+	u64 size = 0;
+
+	// Data read, copied to the guest buffer on the callback thread
+	std::shared_ptr<u8[]> data;
+	u32 buf = 0;
 };
 
-struct fs_aio_thread : ppu_thread
+struct fs_aio_manager
 {
-	using ppu_thread::ppu_thread;
+	// Serializes cellFsAioInit and cellFsAioFinish
+	std::mutex init_mutex;
+	std::set<std::string> mount_points;
+	u32 thread_id = 0;
+
+	std::mutex mutex;
+	std::deque<fs_aio_completion> completed;
+	u32 pending = 0;
+	bool finish = false;
+
+	// Callback thread if it's sleeping
+	atomic_t<ppu_thread*> waiter{};
+
+	// Destroyed first, after all the requests in flight are finished
+	fs::aio_engine engine;
 
-	void non_task()
+	// Queue the callback and wake up the callback thread
+	void complete(fs_aio_completion&& entry)
 	{
-		while (cmd64 cmd = cmd_wait())
+		std::lock_guard lock(mutex);
+
+		completed.emplace_back(std::move(entry));
+		pending--;
+
+		if (const auto ppu = waiter.exchange(nullptr))
 		{
-			const u32 type = cmd.arg1<u32>();
-			const s32 xid = cmd.arg2<s32>();
-			const cmd64 cmd2 = cmd_get(1);
-			const auto aio = cmd2.arg1<vm::ptr<CellFsAio>>();
-			const auto func = cmd2.arg2<fs_aio_cb_t>();
-			cmd_pop(1);
+			lv2_obj::awake(*ppu);
+		}
+	}
 
-			s32 error = CELL_OK;
-			u64 result = 0;
+	void submit(vm::ptr<CellFsAio> aio, fs_aio_cb_t func, s32 xid, bool is_write)
+	{
+		{
+			std::lock_guard lock(mutex);
+			pending++;
+		}
 
-			const auto file = idm::get<lv2_fs_object, lv2_file>(aio->fd);
+		fs_aio_completion entry{aio, func, xid};
 
-			if (!file || (type == 1 && file->flags & CELL_FS_O_WRONLY) || (type == 2 && !(file->flags & CELL_FS_O_ACCMODE)))
+		const auto file = idm::get<lv2_fs_object, lv2_file>(aio->fd);
+
+		if (!file || (is_write ? !(file->flags & CELL_FS_O_ACCMODE) : (file->flags & CELL_FS_O_WRONLY) != 0))
+		{
+			entry.error = CELL_EBADF;
+			complete(std::move(entry));
+			return;
+		}
+
+		const u32 buf = aio->buf.addr();
+		const u64 size = aio->size;
+
+		// vm memory can't be locked while the request is in flight, so it goes through a host buffer
+		std::shared_ptr<u8[]> data(new u8[size]);
+
+		if (is_write)
+		{
+			std::memcpy(data.get(), vm::base(buf), size);
+		}
+
+		fs::aio_engine::request req;
+		req.handle = std::shared_ptr<const fs::file>(file, &file->file);
+		req.offset = aio->offset;
+		req.buffer = data.get();
+		req.size = size;
+		req.is_write = is_write;
+		req.id = xid;
+		req.callback = [this, entry, data, buf, is_write](u64 result) mutable
+		{
+			if (result == fs::aio_engine::canceled)
 			{
-				error = CELL_EBADF;
+				entry.error = CELL_ECANCELED;
+			}
+			else if (result == UINT64_MAX)
+			{
+				entry.error = CELL_EIO;
 			}
 			else
 			{
-				std::lock_guard lock(file->mp->mutex);
-
-				const auto old_pos = file->file.pos(); file->file.seek(aio->offset);
+				entry.size = result;
 
-				result = type == 2
-					? file->op_write(aio->buf, aio->size)
-					: file->op_read(aio->buf, aio->size);
-
-				file->file.seek(old_pos);
+				if (!is_write)
+				{
+					entry.data = std::move(data);
+					entry.buf = buf;
+				}
 			}
 
-			func(*this, aio, error, xid, result);
-			lv2_obj::sleep(*this);
-		}
+			complete(std::move(entry));
+		};
+
+		std::vector<fs::aio_engine::request> requests;
+		requests.emplace_back(std::move(req));
+		engine.submit(std::move(requests));
 	}
 };
 
-struct fs_aio_manager
+// Entry of the PPU thread calling the AIO callbacks
+void fs_aio_callback_thread(ppu_thread& ppu)
 {
-	std::shared_ptr<fs_aio_thread> thread;
-};
+	const auto m = fxm::get<fs_aio_manager>();
+
+	while (m && !ppu.is_stopped())
+	{
+		std::unique_lock lock(m->mutex);
+
+		if (m->completed.empty())
+		{
+			if (m->finish && !m->pending)
+			{
+				lock.unlock();
+				sys_ppu_thread_exit(ppu, 0);
+				return;
+			}
+
+			// Sleep until the next request is finished
+			m->waiter = &ppu;
+			lv2_obj::sleep(ppu);
+			lock.unlock();
+
+			while (m->waiter && !ppu.is_stopped())
+			{
+				thread_ctrl::wait();
+			}
+
+			continue;
+		}
+
+		fs_aio_completion entry = std::move(m->completed.front());
+		m->completed.pop_front();
+		lock.unlock();
+
+		if (entry.data && entry.size)
+		{
+			std::memcpy(vm::base(entry.buf), entry.data.get(), entry.size);
+		}
+
+		if (entry.func)
+		{
+			entry.func(ppu, entry.aio, entry.error, entry.xid, entry.size);
+		}
+	}
+}
 
-s32 cellFsAioInit(vm::cptr<char> mount_point)
+error_code cellFsAioInit(ppu_thread& ppu, vm::cptr<char> mount_point)
 {
 	cellFs.warning("cellFsAioInit(mount_point=%s)", mount_point);
 
-	// TODO: create AIO thread (if not exists) for specified mount point
-	const auto m = fxm::make<fs_aio_manager>();
+	if (!mount_point)
+	{
+		return CELL_EFAULT;
+	}
+
+	// TODO: separate AIO thread for every mount point
+	const auto m = fxm::get_always<fs_aio_manager>();
+
+	std::lock_guard lock(m->init_mutex);
+
+	if (m->mount_points.size() >= CELL_FS_AIO_MAX_FS)
+	{
+		return CELL_EBUSY;
+	}
+
+	if (!m->thread_id)
+	{
+		// Allocates its own TLS and starts the thread
+		vm::var<u64> thread_id;
+		const u32 entry = ppu_function_manager::addr + 8 * FIND_FUNC(fs_aio_callback_thread);
 
-	fmt::throw_exception("cellFsAio disabled, use LLE.");
+		if (error_code res = sys_ppu_thread_create(ppu, thread_id, entry, 0, 1000, 0x4000, SYS_PPU_THREAD_CREATE_JOINABLE, vm::make_str("_cellFsAio")))
+		{
+			return res;
+		}
+
+		m->thread_id = static_cast<u32>(*thread_id);
+	}
+
+	m->mount_points.emplace(mount_point.get_ptr());
 
 	return CELL_OK;
 }
 
-s32 cellFsAioFinish(vm::cptr<char> mount_point)
+error_code cellFsAioFinish(ppu_thread& ppu, vm::cptr<char> mount_point)
 {
 	cellFs.warning("cellFsAioFinish(mount_point=%s)", mount_point);
 
-	// TODO: delete existing AIO thread for specified mount point
+	if (!mount_point)
+	{
+		return CELL_EFAULT;
+	}
 
+	const auto m = fxm::get<fs_aio_manager>();
+
+	if (!m)
+	{
+		return CELL_ENXIO;
+	}
+
+	std::lock_guard lock(m->init_mutex);
+
+	if (!m->mount_points.erase(mount_point.get_ptr()))
+	{
+		return CELL_ENXIO;
+	}
+
+	if (!m->mount_points.empty())
+	{
+		return CELL_OK;
+	}
+
+	// Let the callback thread exit once the pending requests are finished
+	{
+		std::lock_guard lock(m->mutex);
+		m->finish = true;
+
+		if (const auto cpu = m->waiter.exchange(nullptr))
+		{
+			lv2_obj::awake(*cpu);
+		}
+	}
+
+	if (error_code res = sys_ppu_thread_join(ppu, m->thread_id, vm::var<u64>{}))
+	{
+		return res;
+	}
+
+	fxm::remove<fs_aio_manager>();
 	return CELL_OK;
 }
 
@@ -955,11 +1130,7 @@ s32 cellFsAioRead(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
-	({
-		{ 1, xid },
-		{ aio, func },
-	});
+	m->submit(aio, func, xid, false);
 
 	return CELL_OK;
 }
@@ -979,22 +1150,29 @@ s32 cellFsAioWrite(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
-	({
-		{ 2, xid },
-		{ aio, func },
-	});
+	m->submit(aio, func, xid, true);
 
 	return CELL_OK;
 }
 
 s32 cellFsAioCancel(s32 id)
 {
-	cellFs.todo("cellFsAioCancel(id=%d) -> CELL_EINVAL", id);
+	cellFs.warning("cellFsAioCancel(id=%d)", id);
 
-	// TODO: cancelled requests return CELL_ECANCELED through their own callbacks
+	const auto m = fxm::get<fs_aio_manager>();
 
-	return CELL_EINVAL;
+	if (!m)
+	{
+		return CELL_ENXIO;
+	}
+
+	// Only requests which haven't been started can be canceled, they report CELL_ECANCELED through their own callbacks
+	if (id <= 0 || !m->engine.cancel(id))
+	{
+		return CELL_EINVAL;
+	}
+
+	return CELL_OK;
 }
 
 s32 cellFsArcadeHddSerialNumber()
@@ -1022,6 +1200,7 @@ DECLARE(ppu_module_manager::cellFs)("sys_fs", []()
 	REG_FUNC(sys_fs, cellFsAioInit);
 	REG_FUNC(sys_fs, cellFsAioRead);
 	REG_FUNC(sys_fs, cellFsAioWrite);
+	REG_FUNC(sys_fs, fs_aio_callback_thread).flag(MFF_HIDDEN);
 	REG_FUNC(sys_fs, cellFsAllocateFileAreaByFdWithInitialData);
 	REG_FUNC(sys_fs, cellFsAllocateFileAreaByFdWithoutZeroFill);
 	REG_FUNC(sys_fs, cellFsAllocateFileAreaWithInitialData);
@@ -63,21 +63,94 @@ lv2_fs_mount_point* lv2_fs_object::get_mp(const char* filename)
 	return &g_mp_sys_dev_hdd0;
 }
 
-u64 lv2_file::op_read(vm::ptr<void> buf, u64 size)
+// Transfers are split into chunks of this size to bound the intermediate buffer
+static constexpr u32 s_fs_io_chunk = 0x40000;
+
+// Intermediate buffer for the transfers, allocated once per thread
+static u8* get_fs_io_buffer()
 {
-	// Copy data from intermediate buffer (avoid passing vm pointer to a native API)
-	std::unique_ptr<u8[]> local_buf(new u8[size]);
-	const u64 result = file.read(local_buf.get(), size);
-	std::memcpy(buf.get_ptr(), local_buf.get(), result);
+	thread_local const std::unique_ptr<u8[]> s_buf(new u8[s_fs_io_chunk]);
+	return s_buf.get();
+}
+
+// Transfer data between vm memory and a file, io(ptr, pos, size) performs the host I/O for the chunk at pos
+template <bool IsWrite, typename F>
+static u64 fs_transfer_vm(u32 addr, u64 size, F&& io)
+{
+	// Copy data through intermediate buffer (avoid passing vm pointer to a native API)
+	const auto local_buf = get_fs_io_buffer();
+
+	u64 result = 0;
+
+	while (result < size)
+	{
+		const u32 chunk_addr = addr + static_cast<u32>(result);
+		const u32 chunk = static_cast<u32>(std::min<u64>(size - result, s_fs_io_chunk));
+		u64 done;
+
+		if (IsWrite)
+		{
+			std::memcpy(local_buf, vm::base(chunk_addr), chunk);
+			done = io(local_buf, result, chunk);
+		}
+		else
+		{
+			done = io(local_buf, result, chunk);
+		}
+
+		if (done == UINT64_MAX)
+		{
+			// Report what has been transferred so far
+			sys_fs.error("fs_transfer_vm(): %s failed at 0x%llx of 0x%llx bytes", IsWrite ? "write" : "read", result, size);
+			break;
+		}
+
+		if (!IsWrite)
+		{
+			std::memcpy(vm::base(chunk_addr), local_buf, done);
+		}
+
+		result += done;
+
+		if (done < chunk)
+		{
+			break;
+		}
+	}
+
 	return result;
 }
 
+u64 lv2_file::op_read(vm::ptr<void> buf, u64 size)
+{
+	return fs_transfer_vm<false>(buf.addr(), size, [&](void* ptr, u64, u32 chunk)
+	{
+		return file.read(ptr, chunk);
+	});
+}
+
 u64 lv2_file::op_write(vm::cptr<void> buf, u64 size)
 {
-	// Copy data to intermediate buffer (avoid passing vm pointer to a native API)
-	std::unique_ptr<u8[]> local_buf(new u8[size]);
-	std::memcpy(local_buf.get(), buf.get_ptr(), size);
-	return file.write(local_buf.get(), size);
+	return fs_transfer_vm<true>(buf.addr(), size, [&](void* ptr, u64, u32 chunk)
+	{
+		return file.write(ptr, chunk);
+	});
+}
+
+u64 lv2_file::op_read(u64 offset, vm::ptr<void> buf, u64 size)
+{
+	return fs_transfer_vm<false>(buf.addr(), size, [&](void* ptr, u64 pos, u32 chunk)
+	{
+		return file.read_at(offset + pos, ptr, chunk);
+	});
+}
+
+u64 lv2_file::op_write(u64 offset, vm::cptr<void> buf, u64 size)
+{
+	return fs_transfer_vm<true>(buf.addr(), size, [&](void* ptr, u64 pos, u32 chunk)
+	{
+		return file.write_at(offset + pos, ptr, chunk);
+	});
 }
 
 struct lv2_file::file_view : fs::file_base
@@ -109,10 +182,7 @@ struct lv2_file::file_view : fs::file_base
 
 	u64 read(void* buffer, u64 size) override
 	{
-		const u64 old_pos = m_file->file.pos();
-		const u64 new_pos = m_file->file.seek(m_off + m_pos);
-		const u64 result = m_file->file.read(buffer, size);
-		verify(HERE), old_pos == m_file->file.seek(old_pos);
+		const u64 result = m_file->file.read_at(m_off + m_pos, buffer, size);
 
 		m_pos += result;
 		return result;
@@ -123,6 +193,16 @@ struct lv2_file::file_view : fs::file_base
 		return 0;
 	}
 
+	u64 read_at(u64 offset, void* buffer, u64 size) override
+	{
+		return m_file->file.read_at(m_off + offset, buffer, size);
+	}
+
+	u64 write_at(u64 offset, const void* buffer, u64 size) override
+	{
+		return 0;
+	}
+
 	u64 seek(s64 offset, fs::seek_mode whence) override
 	{
 		const s64 new_pos =
@@ -953,21 +1033,15 @@ error_code sys_fs_fcntl(ppu_thread& ppu, u32 fd, u32 op, vm::ptr<void> _arg, u32
 			return CELL_EBADF;
 		}
 
-		std::lock_guard lock(file->mp->mutex);
-
 		if (op == 0x8000000b && file->lock)
 		{
 			return CELL_EBUSY;
 		}
 
-		const u64 old_pos = file->file.pos();
-		const u64 new_pos = file->file.seek(arg->offset);
-
+		// Positional I/O, the file position is left alone so the mount point doesn't need to be locked
 		arg->out_size = op == 0x8000000a
-			? file->op_read(arg->buf, arg->size)
-			: file->op_write(arg->buf, arg->size);
-
-		verify(HERE), old_pos == file->file.seek(old_pos);
+			? file->op_read(arg->offset, arg->buf, arg->size)
+			: file->op_write(arg->offset, arg->buf, arg->size);
 
 		arg->out_code = CELL_OK;
 		return CELL_OK;
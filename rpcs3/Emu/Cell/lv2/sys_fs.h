@@ -187,12 +187,18 @@ struct lv2_file final : lv2_fs_object
 	{
 	}
 
-	// File reading with intermediate buffer
+	// File reading into vm memory
 	u64 op_read(vm::ptr<void> buf, u64 size);
 
-	// File writing with intermediate buffer
+	// File writing from vm memory
 	u64 op_write(vm::cptr<void> buf, u64 size);
 
+	// File reading at the offset (the file position is not used or changed)
+	u64 op_read(u64 offset, vm::ptr<void> buf, u64 size);
+
+	// File writing at the offset (the file position is not used or changed)
+	u64 op_write(u64 offset, vm::cptr<void> buf, u64 size);
+
 	// For MSELF support
 	struct file_view;
 
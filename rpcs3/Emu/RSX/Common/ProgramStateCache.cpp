@@ -1,11 +1,186 @@
 #include "stdafx.h"
 #include "ProgramStateCache.h"
 #include "Emu/System.h"
+#include "Utilities/sysinfo.h"
 
 #include <stack>
 
 using namespace program_hash_util;
 
+const bool s_use_sse42 =
+#ifdef _MSC_VER
+	utils::has_sse42();
+#elif __SSE4_2__
+	true;
+#else
+	false;
+#endif
+
+const bool s_use_avx2 =
+#ifdef _MSC_VER
+	utils::has_avx2();
+#elif __AVX2__
+	true;
+#else
+	false;
+#endif
+
+namespace
+{
+	// 64-bit FNV-1a step over one value
+	template <typename T>
+	void hash_combine(u64& hash, const T& value)
+	{
+		const u8* bytes = reinterpret_cast<const u8*>(&value);
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;
+		}
+	}
+
+	// Vector version of fragment_program_utils::is_constant over the three source operands; the constant follows the instruction
+	bool fragment_instruction_has_constant(const __m128i& inst)
+	{
+		const __m128i types = _mm_and_si128(inst, _mm_set1_epi32(0x300));
+		const int constants = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(types, _mm_set1_epi32(0x200))));
+
+		// Word 0 holds the destination, it never references a constant
+		return (constants & 0xE) != 0;
+	}
+
+	bool fragment_instruction_is_last(const __m128i& inst)
+	{
+		return (_mm_cvtsi128_si32(inst) & 0x100) != 0;
+	}
+
+	bool vertex_program_state_equal(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2)
+	{
+		if (binary1.output_mask != binary2.output_mask)
+			return false;
+		if (binary1.texture_dimensions != binary2.texture_dimensions)
+			return false;
+		if (binary1.data.size() != binary2.data.size())
+			return false;
+		if (binary1.jump_table != binary2.jump_table)
+			return false;
+		if (!binary1.skip_vertex_input_check && !binary2.skip_vertex_input_check && binary1.rsx_vertex_inputs != binary2.rsx_vertex_inputs)
+			return false;
+
+		return true;
+	}
+
+	bool vertex_program_ucode_equal(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2)
+	{
+		const qword *instBuffer1 = (const qword*)binary1.data.data();
+		const qword *instBuffer2 = (const qword*)binary2.data.data();
+		size_t instIndex = 0;
+		for (unsigned i = 0; i < binary1.data.size() / 4; i++)
+		{
+			const auto active = binary1.instruction_mask[instIndex];
+			if (active != binary2.instruction_mask[instIndex])
+			{
+				return false;
+			}
+
+			if (active)
+			{
+				const qword& inst1 = instBuffer1[instIndex];
+				const qword& inst2 = instBuffer2[instIndex];
+				if (inst1.dword[0] != inst2.dword[0] || inst1.dword[1] != inst2.dword[1])
+				{
+					return false;
+				}
+			}
+
+			instIndex++;
+		}
+
+		return true;
+	}
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+	bool vertex_program_ucode_equal_avx2(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2)
+	{
+		const qword *instBuffer1 = (const qword*)binary1.data.data();
+		const qword *instBuffer2 = (const qword*)binary2.data.data();
+		const u32 count = ::size32(binary1.data) / 4;
+		const std::bitset<512> low_bits(~0ull);
+
+		// The instruction masks are compared 64 bits at a time, then the active instructions two at a time
+		for (u32 base = 0; base < count; base += 64)
+		{
+			const u32 length = std::min<u32>(count - base, 64);
+			const u64 valid = length == 64 ? ~0ull : (1ull << length) - 1;
+			const u64 active = ((binary1.instruction_mask >> base) & low_bits).to_ullong() & valid;
+
+			if (active != (((binary2.instruction_mask >> base) & low_bits).to_ullong() & valid))
+			{
+				return false;
+			}
+
+			for (u32 i = 0; i < length; i += 2)
+			{
+				const u32 pair = (active >> i) & 3;
+				if (!pair)
+				{
+					continue;
+				}
+
+				// Byte lanes of inactive instructions are ignored
+				const u32 required = ((pair & 1) ? 0xFFFFu : 0u) | ((pair & 2) ? 0xFFFF0000u : 0u);
+				u32 equal;
+
+				if (i + 1 < length)
+				{
+					const __m256i inst1 = _mm256_loadu_si256((const __m256i*)(instBuffer1 + base + i));
+					const __m256i inst2 = _mm256_loadu_si256((const __m256i*)(instBuffer2 + base + i));
+					equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(inst1, inst2));
+				}
+				else
+				{
+					const __m128i inst1 = _mm_loadu_si128((const __m128i*)(instBuffer1 + base + i));
+					const __m128i inst2 = _mm_loadu_si128((const __m128i*)(instBuffer2 + base + i));
+					equal = _mm_movemask_epi8(_mm_cmpeq_epi8(inst1, inst2));
+				}
+
+				if (~equal & required)
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+#else
+	bool vertex_program_ucode_equal_avx2(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2)
+	{
+		return vertex_program_ucode_equal(binary1, binary2);
+	}
+#endif
+
+	bool fragment_program_state_equal(const RSXFragmentProgram& binary1, const RSXFragmentProgram& binary2)
+	{
+		if (binary1.ctrl != binary2.ctrl || binary1.texture_dimensions != binary2.texture_dimensions || binary1.unnormalized_coords != binary2.unnormalized_coords ||
+			binary1.back_color_diffuse_output != binary2.back_color_diffuse_output || binary1.back_color_specular_output != binary2.back_color_specular_output ||
+			binary1.front_back_color_enabled != binary2.front_back_color_enabled ||
+			binary1.shadow_textures != binary2.shadow_textures || binary1.redirected_textures != binary2.redirected_textures)
+			return false;
+
+		for (u8 index = 0; index < 16; ++index)
+		{
+			if (binary1.textures_alpha_kill[index] != binary2.textures_alpha_kill[index])
+				return false;
+
+			if (binary1.textures_zfunc[index] != binary2.textures_zfunc[index])
+				return false;
+		}
+
+		return true;
+	}
+}
+
 size_t vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &program)
 {
 	// 64-bit Fowler/Noll/Vo FNV-1a hash code
@@ -29,6 +204,72 @@ size_t vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgra
 	return hash;
 }
 
+size_t vertex_program_utils::get_vertex_program_ucode_crc(const RSXVertexProgram &program)
+{
+#if defined(_MSC_VER) || defined(__SSE4_2__)
+	if (LIKELY(s_use_sse42))
+	{
+		// Two independent streams keep the CRC unit busy, each gives 32 bits of the result
+		const qword *instbuffer = (const qword*)program.data.data();
+		u64 crc0 = 0xFFFFFFFF;
+		u64 crc1 = 0xFFFFFFFF;
+
+		for (unsigned i = 0; i < program.data.size() / 4; i++)
+		{
+			if (program.instruction_mask[i])
+			{
+				crc0 = _mm_crc32_u64(crc0, instbuffer[i].dword[0]);
+				crc1 = _mm_crc32_u64(crc1, instbuffer[i].dword[1]);
+			}
+		}
+
+		return (crc1 << 32) | crc0;
+	}
+#endif
+
+	return get_vertex_program_ucode_hash(program);
+}
+
+u64 vertex_program_utils::get_vertex_program_cache_key(const RSXVertexProgram &program)
+{
+	u64 hash = 0xCBF29CE484222325ULL;
+	hash_combine(hash, decompiler_version);
+	hash_combine(hash, u64{ get_vertex_program_ucode_hash(program) });
+	hash_combine(hash, program.output_mask);
+	hash_combine(hash, program.texture_dimensions);
+	hash_combine(hash, ::size32(program.data));
+
+	for (const u32 target : program.jump_table)
+	{
+		hash_combine(hash, target);
+	}
+
+	for (u32 i = 0; i < 512; i += 64)
+	{
+		hash_combine(hash, ((program.instruction_mask >> i) & std::bitset<512>(~0ull)).to_ullong());
+	}
+
+	return hash;
+}
+
+u64 vertex_program_utils::get_vertex_program_fingerprint(const RSXVertexProgram &program)
+{
+	u64 hash = 0xCBF29CE484222325ULL;
+	hash_combine(hash, program.output_mask);
+	hash_combine(hash, program.texture_dimensions);
+	hash_combine(hash, program.base_address);
+	hash_combine(hash, program.entry);
+	hash_combine(hash, ::size32(program.data));
+	hash_combine(hash, ::size32(program.jump_table));
+
+	if (program.data.size() >= 4)
+	{
+		hash_combine(hash, *reinterpret_cast<const qword*>(program.data.data()));
+	}
+
+	return hash;
+}
+
 vertex_program_utils::vertex_program_metadata vertex_program_utils::analyse_vertex_program(const u32* data, u32 entry, RSXVertexProgram& dst_prog)
 {
 	vertex_program_utils::vertex_program_metadata result{};
@@ -246,7 +487,7 @@ vertex_program_utils::vertex_program_metadata vertex_program_utils::analyse_vert
 
 size_t vertex_program_storage_hash::operator()(const RSXVertexProgram &program) const
 {
-	size_t hash = vertex_program_utils::get_vertex_program_ucode_hash(program);
+	size_t hash = vertex_program_utils::get_vertex_program_ucode_crc(program);
 	hash ^= program.output_mask;
 	hash ^= program.texture_dimensions;
 	return hash;
@@ -254,42 +495,18 @@ size_t vertex_program_storage_hash::operator()(const RSXVertexProgram &program)
 
 bool vertex_program_compare::operator()(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2) const
 {
-	if (binary1.output_mask != binary2.output_mask)
-		return false;
-	if (binary1.texture_dimensions != binary2.texture_dimensions)
-		return false;
-	if (binary1.data.size() != binary2.data.size())
-		return false;
-	if (binary1.jump_table != binary2.jump_table)
-		return false;
-	if (!binary1.skip_vertex_input_check && !binary2.skip_vertex_input_check && binary1.rsx_vertex_inputs != binary2.rsx_vertex_inputs)
+	if (!vertex_program_state_equal(binary1, binary2))
 		return false;
 
-	const qword *instBuffer1 = (const qword*)binary1.data.data();
-	const qword *instBuffer2 = (const qword*)binary2.data.data();
-	size_t instIndex = 0;
-	for (unsigned i = 0; i < binary1.data.size() / 4; i++)
-	{
-		const auto active = binary1.instruction_mask[instIndex];
-		if (active != binary2.instruction_mask[instIndex])
-		{
-			return false;
-		}
+	if (LIKELY(s_use_avx2))
+		return vertex_program_ucode_equal_avx2(binary1, binary2);
 
-		if (active)
-		{
-			const qword& inst1 = instBuffer1[instIndex];
-			const qword& inst2 = instBuffer2[instIndex];
-			if (inst1.dword[0] != inst2.dword[0] || inst1.dword[1] != inst2.dword[1])
-			{
-				return false;
-			}
-		}
-
-		instIndex++;
-	}
+	return vertex_program_ucode_equal(binary1, binary2);
+}
 
-	return true;
+bool vertex_program_compare::compare_scalar(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2)
+{
+	return vertex_program_state_equal(binary1, binary2) && vertex_program_ucode_equal(binary1, binary2);
 }
 
 
@@ -418,9 +635,69 @@ size_t fragment_program_utils::get_fragment_program_ucode_hash(const RSXFragment
 	return 0;
 }
 
+size_t fragment_program_utils::get_fragment_program_ucode_crc(const RSXFragmentProgram& program)
+{
+#if defined(_MSC_VER) || defined(__SSE4_2__)
+	if (LIKELY(s_use_sse42))
+	{
+		const qword *instbuffer = (const qword*)program.addr;
+		u64 crc0 = 0xFFFFFFFF;
+		u64 crc1 = 0xFFFFFFFF;
+		size_t instIndex = 0;
+
+		while (true)
+		{
+			const qword& inst = instbuffer[instIndex];
+			const __m128i vector = _mm_loadu_si128((const __m128i*)&inst);
+			crc0 = _mm_crc32_u64(crc0, inst.dword[0]);
+			crc1 = _mm_crc32_u64(crc1, inst.dword[1]);
+
+			// Skip constants
+			instIndex += fragment_instruction_has_constant(vector) ? 2 : 1;
+
+			if (fragment_instruction_is_last(vector))
+				return (crc1 << 32) | crc0;
+		}
+	}
+#endif
+
+	return get_fragment_program_ucode_hash(program);
+}
+
+u64 fragment_program_utils::get_fragment_program_cache_key(const RSXFragmentProgram& program)
+{
+	u64 hash = 0xCBF29CE484222325ULL;
+	hash_combine(hash, decompiler_version);
+	hash_combine(hash, u64{ get_fragment_program_ucode_hash(program) });
+	hash_combine(hash, program.ctrl);
+	hash_combine(hash, program.texture_dimensions);
+	hash_combine(hash, program.unnormalized_coords);
+	hash_combine(hash, program.shadow_textures);
+	hash_combine(hash, program.redirected_textures);
+	hash_combine(hash, u8(program.front_back_color_enabled | program.back_color_diffuse_output << 1 | program.back_color_specular_output << 2));
+	hash_combine(hash, program.textures_alpha_kill);
+	hash_combine(hash, program.textures_zfunc);
+	return hash;
+}
+
+u64 fragment_program_utils::get_fragment_program_fingerprint(const RSXFragmentProgram& program)
+{
+	u64 hash = 0xCBF29CE484222325ULL;
+	hash_combine(hash, program.offset);
+	hash_combine(hash, program.ucode_length);
+	hash_combine(hash, program.ctrl);
+	hash_combine(hash, program.texture_dimensions);
+	hash_combine(hash, program.unnormalized_coords);
+	hash_combine(hash, program.shadow_textures);
+	hash_combine(hash, program.redirected_textures);
+	hash_combine(hash, u8(program.front_back_color_enabled | program.back_color_diffuse_output << 1 | program.back_color_specular_output << 2));
+	hash_combine(hash, *static_cast<const qword*>(program.addr));
+	return hash;
+}
+
 size_t fragment_program_storage_hash::operator()(const RSXFragmentProgram& program) const
 {
-	size_t hash = fragment_program_utils::get_fragment_program_ucode_hash(program);
+	size_t hash = fragment_program_utils::get_fragment_program_ucode_crc(program);
 	hash ^= program.ctrl;
 	hash ^= program.texture_dimensions;
 	hash ^= program.unnormalized_coords;
@@ -435,20 +712,32 @@ size_t fragment_program_storage_hash::operator()(const RSXFragmentProgram& progr
 
 bool fragment_program_compare::operator()(const RSXFragmentProgram& binary1, const RSXFragmentProgram& binary2) const
 {
-	if (binary1.ctrl != binary2.ctrl || binary1.texture_dimensions != binary2.texture_dimensions || binary1.unnormalized_coords != binary2.unnormalized_coords ||
-		binary1.back_color_diffuse_output != binary2.back_color_diffuse_output || binary1.back_color_specular_output != binary2.back_color_specular_output ||
-		binary1.front_back_color_enabled != binary2.front_back_color_enabled ||
-		binary1.shadow_textures != binary2.shadow_textures || binary1.redirected_textures != binary2.redirected_textures)
+	if (!fragment_program_state_equal(binary1, binary2))
 		return false;
 
-	for (u8 index = 0; index < 16; ++index)
+	const qword *instBuffer1 = (const qword*)binary1.addr;
+	const qword *instBuffer2 = (const qword*)binary2.addr;
+	size_t instIndex = 0;
+	while (true)
 	{
-		if (binary1.textures_alpha_kill[index] != binary2.textures_alpha_kill[index])
-			return false;
+		const __m128i inst1 = _mm_loadu_si128((const __m128i*)(instBuffer1 + instIndex));
+		const __m128i inst2 = _mm_loadu_si128((const __m128i*)(instBuffer2 + instIndex));
 
-		if (binary1.textures_zfunc[index] != binary2.textures_zfunc[index])
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(inst1, inst2)) != 0xFFFF)
 			return false;
+
+		// Both instructions are equal from here on, so only one of them needs to be decoded
+		instIndex += fragment_instruction_has_constant(inst1) ? 2 : 1;
+
+		if (fragment_instruction_is_last(inst1))
+			return true;
 	}
+}
+
+bool fragment_program_compare::compare_scalar(const RSXFragmentProgram& binary1, const RSXFragmentProgram& binary2)
+{
+	if (!fragment_program_state_equal(binary1, binary2))
+		return false;
 
 	const qword *instBuffer1 = (const qword*)binary1.addr;
 	const qword *instBuffer2 = (const qword*)binary2.addr;
@@ -2,12 +2,14 @@
 
 #include "Emu/RSX/RSXFragmentProgram.h"
 #include "Emu/RSX/RSXVertexProgram.h"
+#include "shader_cache_archive.h"
 
 #include "Utilities/GSL.h"
 #include "Utilities/hash.h"
 #include "Utilities/mutex.h"
 #include "Utilities/Log.h"
 
+#include <array>
 #include <deque>
 
 enum class SHADER_TYPE
@@ -27,6 +29,9 @@ namespace program_hash_util
 		u32 word[4];
 	};
 
+	// Part of the keys of decompiled programs stored on disk; bump whenever the decompilers change their output
+	constexpr u32 decompiler_version = 1;
+
 	struct vertex_program_utils
 	{
 		struct vertex_program_metadata
@@ -36,8 +41,18 @@ namespace program_hash_util
 			u32 referenced_textures_mask;
 		};
 
+		// Persistent ucode hash, used in the on-disk cache keys; do not change
 		static size_t get_vertex_program_ucode_hash(const RSXVertexProgram &program);
 
+		// In-memory ucode hash, CRC32C based if the CPU has SSE4.2. Differs between hosts, never store it.
+		static size_t get_vertex_program_ucode_crc(const RSXVertexProgram &program);
+
+		// Key covering everything vertex_program_compare looks at, stable across runs
+		static u64 get_vertex_program_cache_key(const RSXVertexProgram &program);
+
+		// Cheap hash of the state the program was fetched with; skips the ucode body, so equal fingerprints still need a compare
+		static u64 get_vertex_program_fingerprint(const RSXVertexProgram &program);
+
 		static vertex_program_metadata analyse_vertex_program(const u32* data, u32 entry, RSXVertexProgram& dst_prog);
 	};
 
@@ -49,6 +64,9 @@ namespace program_hash_util
 	struct vertex_program_compare
 	{
 		bool operator()(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2) const;
+
+		// Instruction by instruction version of operator(), which compares two instructions per step with AVX2 when available
+		static bool compare_scalar(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2);
 	};
 
 	struct fragment_program_utils
@@ -70,7 +88,17 @@ namespace program_hash_util
 
 		static fragment_program_metadata analyse_fragment_program(void *ptr);
 
+		// Persistent ucode hash, used in the on-disk cache keys; do not change
 		static size_t get_fragment_program_ucode_hash(const RSXFragmentProgram &program);
+
+		// In-memory ucode hash, CRC32C based if the CPU has SSE4.2. Differs between hosts, never store it.
+		static size_t get_fragment_program_ucode_crc(const RSXFragmentProgram &program);
+
+		// Key covering everything fragment_program_compare looks at, stable across runs
+		static u64 get_fragment_program_cache_key(const RSXFragmentProgram &program);
+
+		// Cheap hash of the state the program was fetched with; skips the ucode body, so equal fingerprints still need a compare
+		static u64 get_fragment_program_fingerprint(const RSXFragmentProgram &program);
 	};
 
 	struct fragment_program_storage_hash
@@ -81,6 +109,9 @@ namespace program_hash_util
 	struct fragment_program_compare
 	{
 		bool operator()(const RSXFragmentProgram &binary1, const RSXFragmentProgram &binary2) const;
+
+		// Word by word version of operator(), which tests whole instructions and their operand types with SSE
+		static bool compare_scalar(const RSXFragmentProgram &binary1, const RSXFragmentProgram &binary2);
 	};
 }
 
@@ -97,6 +128,10 @@ namespace program_hash_util
 * It should also contains the following function member :
 * - static void recompile_fragment_program(RSXFragmentProgram *RSXFP, FragmentProgramData& fragmentProgramData, size_t ID);
 * - static void recompile_vertex_program(RSXVertexProgram *RSXVP, VertexProgramData& vertexProgramData, size_t ID);
+* - static bool load_fragment_program(const rsx::shader_cache_archive& archive, u64 key, const RSXFragmentProgram &RSXFP, FragmentProgramData& fragmentProgramData, size_t ID);
+* - static bool load_vertex_program(const rsx::shader_cache_archive& archive, u64 key, const RSXVertexProgram &RSXVP, VertexProgramData& vertexProgramData, size_t ID);
+* - static void store_fragment_program(rsx::shader_cache_archive& archive, u64 key, const FragmentProgramData& fragmentProgramData);
+* - static void store_vertex_program(rsx::shader_cache_archive& archive, u64 key, const VertexProgramData& vertexProgramData);
 * - static PipelineData build_program(VertexProgramData &vertexProgramData, FragmentProgramData &fragmentProgramData, const PipelineProperties &pipelineProperties, const ExtraData& extraData);
 * - static void validate_pipeline_properties(const VertexProgramData &vertexProgramData, const FragmentProgramData &fragmentProgramData, PipelineProperties& props);
 */
@@ -139,6 +174,22 @@ class program_state_cache
 		}
 	};
 
+	// Direct-mapped cache of recent lookups in front of the program and pipeline maps.
+	// The programs are not hashed on a hit; the stored keys are compared against the requested ones instead,
+	// since fragment ucode lives in memory and can change without any register write.
+	// It only saves the map lookups: the programs have already been decoded and analysed by the caller, and a hit still compares them in full.
+	struct pipeline_lookup_entry
+	{
+		u64 fingerprint = 0;
+		const RSXVertexProgram* vp = nullptr;
+		const RSXFragmentProgram* fp = nullptr;
+		pipeline_properties requested_props{};
+		pipeline_properties validated_props{};
+		pipeline_storage_type* pipeline = nullptr;
+	};
+
+	static constexpr u32 lookup_cache_size = 64;
+
 public:
 	struct async_link_task_entry
 	{
@@ -185,46 +236,68 @@ protected:
 	binary_to_fragment_program m_fragment_shader_cache;
 	std::unordered_map <pipeline_key, pipeline_storage_type, pipeline_key_hash, pipeline_key_compare> m_storage;
 
+	std::array<pipeline_lookup_entry, lookup_cache_size> m_lookup_cache;
+	u32 m_lookup_cache_hits = 0;
+	u32 m_lookup_cache_misses = 0;
+
 	std::unordered_map <pipeline_key, std::unique_ptr<async_link_task_entry>, pipeline_key_hash, pipeline_key_compare> m_link_queue;
 	std::deque<async_decompile_task_entry> m_decompile_queue;
 
+	// Optional persistent store of decompiled programs, consulted before invoking the decompiler
+	rsx::shader_cache_archive* m_program_archive = nullptr;
+
 	vertex_program_type __null_vertex_program;
 	fragment_program_type __null_fragment_program;
 	pipeline_storage_type __null_pipeline_handle;
 
-	/// bool here to inform that the program was preexisting.
-	std::tuple<const vertex_program_type&, bool> search_vertex_program(const RSXVertexProgram& rsx_vp, bool force_load = true)
+	/// bool here to inform that the program was preexisting. The last element points to the stored key, if any.
+	std::tuple<const vertex_program_type&, bool, const RSXVertexProgram*> search_vertex_program(const RSXVertexProgram& rsx_vp, bool force_load = true)
 	{
 		const auto& I = m_vertex_shader_cache.find(rsx_vp);
 		if (I != m_vertex_shader_cache.end())
 		{
-			return std::forward_as_tuple(I->second, true);
+			return std::forward_as_tuple(I->second, true, &I->first);
 		}
 
 		if (!force_load)
 		{
-			return std::forward_as_tuple(__null_vertex_program, false);
+			return std::forward_as_tuple(__null_vertex_program, false, nullptr);
 		}
 
 		LOG_NOTICE(RSX, "VP not found in buffer!");
-		vertex_program_type& new_shader = m_vertex_shader_cache[rsx_vp];
-		backend_traits::recompile_vertex_program(rsx_vp, new_shader, m_next_id++);
+		const auto& N = m_vertex_shader_cache.try_emplace(rsx_vp).first;
+		vertex_program_type& new_shader = N->second;
+
+		if (!m_program_archive)
+		{
+			backend_traits::recompile_vertex_program(rsx_vp, new_shader, m_next_id++);
+			return std::forward_as_tuple(new_shader, false, &N->first);
+		}
+
+		const u64 cache_key = program_hash_util::vertex_program_utils::get_vertex_program_cache_key(rsx_vp);
+		if (!backend_traits::load_vertex_program(*m_program_archive, cache_key, rsx_vp, new_shader, m_next_id))
+		{
+			backend_traits::recompile_vertex_program(rsx_vp, new_shader, m_next_id);
+			backend_traits::store_vertex_program(*m_program_archive, cache_key, new_shader);
+		}
+
+		m_next_id++;
 
-		return std::forward_as_tuple(new_shader, false);
+		return std::forward_as_tuple(new_shader, false, &N->first);
 	}
 
-	/// bool here to inform that the program was preexisting.
-	std::tuple<const fragment_program_type&, bool> search_fragment_program(const RSXFragmentProgram& rsx_fp, bool force_load = true)
+	/// bool here to inform that the program was preexisting. The last element points to the stored key, if any.
+	std::tuple<const fragment_program_type&, bool, const RSXFragmentProgram*> search_fragment_program(const RSXFragmentProgram& rsx_fp, bool force_load = true)
 	{
 		const auto& I = m_fragment_shader_cache.find(rsx_fp);
 		if (I != m_fragment_shader_cache.end())
 		{
-			return std::forward_as_tuple(I->second, true);
+			return std::forward_as_tuple(I->second, true, &I->first);
 		}
 
 		if (!force_load)
 		{
-			return std::forward_as_tuple(__null_fragment_program, false);
+			return std::forward_as_tuple(__null_fragment_program, false, nullptr);
 		}
 
 		LOG_NOTICE(RSX, "FP not found in buffer!");
@@ -232,10 +305,44 @@ protected:
 		std::memcpy(fragment_program_ucode_copy, rsx_fp.addr, rsx_fp.ucode_length);
 		RSXFragmentProgram new_fp_key = rsx_fp;
 		new_fp_key.addr = fragment_program_ucode_copy;
-		fragment_program_type &new_shader = m_fragment_shader_cache[new_fp_key];
-		backend_traits::recompile_fragment_program(rsx_fp, new_shader, m_next_id++);
+		const auto& N = m_fragment_shader_cache.try_emplace(new_fp_key).first;
+		fragment_program_type &new_shader = N->second;
+
+		if (!m_program_archive)
+		{
+			backend_traits::recompile_fragment_program(rsx_fp, new_shader, m_next_id++);
+			return std::forward_as_tuple(new_shader, false, &N->first);
+		}
 
-		return std::forward_as_tuple(new_shader, false);
+		const u64 cache_key = program_hash_util::fragment_program_utils::get_fragment_program_cache_key(rsx_fp);
+		if (!backend_traits::load_fragment_program(*m_program_archive, cache_key, rsx_fp, new_shader, m_next_id))
+		{
+			backend_traits::recompile_fragment_program(rsx_fp, new_shader, m_next_id);
+			backend_traits::store_fragment_program(*m_program_archive, cache_key, new_shader);
+		}
+
+		m_next_id++;
+
+		return std::forward_as_tuple(new_shader, false, &N->first);
+	}
+
+	static u64 get_lookup_fingerprint(const RSXVertexProgram& vp, const RSXFragmentProgram& fp, const pipeline_properties& props)
+	{
+		u64 hash = program_hash_util::vertex_program_utils::get_vertex_program_fingerprint(vp);
+		hash = (hash ^ program_hash_util::fragment_program_utils::get_fragment_program_fingerprint(fp)) * 0x100000001B3ULL;
+		hash = (hash ^ rpcs3::hash_struct<pipeline_properties>(props)) * 0x100000001B3ULL;
+		return hash;
+	}
+
+	void update_lookup_cache(pipeline_lookup_entry& entry, u64 fingerprint, const RSXVertexProgram* vp, const RSXFragmentProgram* fp,
+		const pipeline_properties& requested_props, const pipeline_properties& validated_props, pipeline_storage_type& pipeline)
+	{
+		entry.fingerprint = fingerprint;
+		entry.vp = vp;
+		entry.fp = fp;
+		entry.requested_props = requested_props;
+		entry.validated_props = validated_props;
+		entry.pipeline = &pipeline;
 	}
 
 public:
@@ -318,6 +425,12 @@ public:
 		}
 	}
 
+	// Decompiled programs are looked up in and added to archive; pass nullptr to always decompile
+	void set_program_archive(rsx::shader_cache_archive* archive)
+	{
+		m_program_archive = archive;
+	}
+
 	const vertex_program_type& get_transform_program(const RSXVertexProgram& rsx_vp) const
 	{
 		auto I = m_vertex_shader_cache.find(rsx_vp);
@@ -407,6 +520,23 @@ public:
 		Args&& ...args
 		)
 	{
+		const u64 fingerprint = get_lookup_fingerprint(vertexShader, fragmentShader, pipelineProperties);
+		auto& lookup = m_lookup_cache[fingerprint % lookup_cache_size];
+
+		if (lookup.pipeline && lookup.fingerprint == fingerprint && lookup.requested_props == pipelineProperties &&
+			program_hash_util::vertex_program_compare()(*lookup.vp, vertexShader) &&
+			program_hash_util::fragment_program_compare()(*lookup.fp, fragmentShader))
+		{
+			m_lookup_cache_hits++;
+			m_cache_miss_flag = false;
+			m_program_compiled_flag = false;
+			pipelineProperties = lookup.validated_props;
+			return *lookup.pipeline;
+		}
+
+		m_lookup_cache_misses++;
+		const pipeline_properties requested_props = pipelineProperties;
+
 		const auto &vp_search = search_vertex_program(vertexShader, !allow_async);
 		const auto &fp_search = search_fragment_program(fragmentShader, !allow_async);
 
@@ -429,6 +559,7 @@ public:
 			if (I != m_storage.end())
 			{
 				m_cache_miss_flag = false;
+				update_lookup_cache(lookup, fingerprint, std::get<2>(vp_search), std::get<2>(fp_search), requested_props, pipelineProperties, I->second);
 				return I->second;
 			}
 
@@ -446,6 +577,7 @@ public:
 				std::lock_guard lock(m_pipeline_mutex);
 				auto &rtn = m_storage[key] = std::move(pipeline);
 				LOG_SUCCESS(RSX, "New program compiled successfully");
+				update_lookup_cache(lookup, fingerprint, std::get<2>(vp_search), std::get<2>(fp_search), requested_props, pipelineProperties, rtn);
 				return rtn;
 			}
 		}
@@ -573,8 +705,21 @@ public:
 		}
 	}
 
+	// Lookups answered by the direct-mapped cache, and the ones that went through the program maps, since the last reset
+	std::pair<u32, u32> get_lookup_cache_statistics() const
+	{
+		return { m_lookup_cache_hits, m_lookup_cache_misses };
+	}
+
+	void reset_lookup_cache_statistics()
+	{
+		m_lookup_cache_hits = 0;
+		m_lookup_cache_misses = 0;
+	}
+
 	void clear()
 	{
+		m_lookup_cache = {};
 		m_storage.clear();
 	}
 };
@@ -49,6 +49,7 @@ namespace rsx
 		rsx::texture_dimension_extended image_type = texture_dimension_extended::texture_dimension_2d;
 		bool is_depth_texture = false;
 		bool is_cyclic_reference = false;
+		bool is_hash_verified = false; // Source memory is not page protected; the lookup must be repeated before every use
 		f32 scale_x = 1.f;
 		f32 scale_y = 1.f;
 
@@ -118,6 +119,12 @@ size_t get_placed_texture_storage_size(const rsx::vertex_texture &texture, size_
 std::vector<rsx_subresource_layout> get_subresources_layout(const rsx::fragment_texture &texture);
 std::vector<rsx_subresource_layout> get_subresources_layout(const rsx::vertex_texture &texture);
 
+/**
+ * get all rsx_subresource_layout for a texture described by raw register values and stored at pixels.
+ * Format is the raw texture format register (LN and UN bits are ignored).
+ */
+std::vector<rsx_subresource_layout> get_subresources_layout(const gsl::byte *pixels, u32 gcm_format, u16 width, u16 height, u16 depth, u8 layer_count, u16 mipmap_count, u32 pitch, bool is_swizzled, bool has_border);
+
 void upload_texture_subresource(gsl::span<gsl::byte> dst_buffer, const rsx_subresource_layout &src_layout, int format, bool is_swizzled, bool vtc_support, size_t dst_row_pitch_multiple_of);
 
 u8 get_format_block_size_in_bytes(int format);
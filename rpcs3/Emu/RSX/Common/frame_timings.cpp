@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "frame_timings.h"
+
+namespace rsx
+{
+	static const char* const s_stage_names[] =
+	{
+		"other",
+		"idle",
+		"fifo_decode",
+		"method_dispatch",
+		"program_lookup",
+		"texture_cache",
+		"vertex_upload",
+		"flush_wait",
+		"flip",
+	};
+
+	static_assert(std::size(s_stage_names) == static_cast<u32>(frame_stage::stage_count), "Stage names do not match the stage list");
+
+	void frame_timing_recorder::open(const std::string& path, bool json)
+	{
+		if (!m_file.open(path, fs::rewrite))
+		{
+			LOG_ERROR(RSX, "Frame timing log %s could not be created (%s)", path, fs::g_tls_error);
+			return;
+		}
+
+		m_json = json;
+		m_enabled = true;
+		m_stage = frame_stage::other;
+		m_stage_times = {};
+		m_frame = 0;
+		m_frame_start = m_last_timestamp = now();
+
+		if (!m_json)
+		{
+			std::string header = "frame,frame_time_us,draw_calls";
+
+			for (const auto name : s_stage_names)
+			{
+				header += ',';
+				header += name;
+				header += "_us";
+			}
+
+			m_file.write(header + '\n');
+		}
+
+		LOG_NOTICE(RSX, "Writing frame timings to %s", path);
+	}
+
+	void frame_timing_recorder::end_frame(u32 draw_calls)
+	{
+		if (!m_enabled)
+		{
+			return;
+		}
+
+		// Close the interval of the current stage; it carries on into the next frame
+		enter(m_stage);
+
+		const u64 frame_time = m_last_timestamp - m_frame_start;
+		std::string line;
+
+		if (m_json)
+		{
+			line = fmt::format("{\"frame\":%llu,\"frame_time_us\":%llu,\"draw_calls\":%u", m_frame, frame_time / 1000, draw_calls);
+
+			for (u32 i = 0; i < num_stages; ++i)
+			{
+				fmt::append(line, ",\"%s_us\":%llu", s_stage_names[i], m_stage_times[i] / 1000);
+			}
+
+			line += "}\n";
+		}
+		else
+		{
+			line = fmt::format("%llu,%llu,%u", m_frame, frame_time / 1000, draw_calls);
+
+			for (const u64 time : m_stage_times)
+			{
+				fmt::append(line, ",%llu", time / 1000);
+			}
+
+			line += '\n';
+		}
+
+		m_file.write(line);
+
+		m_stage_times = {};
+		m_frame_start = m_last_timestamp;
+		m_frame++;
+	}
+}
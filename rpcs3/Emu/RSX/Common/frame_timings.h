@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Utilities/types.h"
+#include "Utilities/File.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <utility>
+
+namespace rsx
+{
+	enum class frame_stage : u32
+	{
+		other = 0,       // RSX thread time not covered by any other stage
+		idle,            // Waiting for FIFO commands
+		fifo_decode,
+		method_dispatch,
+		program_lookup,
+		texture_cache,
+		vertex_upload,
+		flush_wait,
+		flip,
+
+		stage_count
+	};
+
+	/**
+	 * Splits the RSX thread time of every frame into stages and writes one CSV or JSON line per frame.
+	 * Time is attributed exclusively: entering a stage pauses the one it was entered from,
+	 * so a texture upload inside a draw method is not counted as method dispatch as well.
+	 * Only meant to be used from the RSX thread.
+	 */
+	class frame_timing_recorder
+	{
+		static constexpr u32 num_stages = static_cast<u32>(frame_stage::stage_count);
+
+		fs::file m_file;
+		bool m_enabled = false;
+		bool m_json = false;
+
+		frame_stage m_stage = frame_stage::other;
+		u64 m_last_timestamp = 0;
+		u64 m_frame_start = 0;
+		u64 m_frame = 0;
+		std::array<u64, num_stages> m_stage_times{};
+
+		static u64 now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	public:
+		// Starts recording to the given file; the extension is not changed
+		void open(const std::string& path, bool json);
+
+		bool enabled() const
+		{
+			return m_enabled;
+		}
+
+		// Makes stage the current stage, returns the previous one
+		frame_stage enter(frame_stage stage)
+		{
+			const u64 timestamp = now();
+			m_stage_times[static_cast<u32>(m_stage)] += timestamp - m_last_timestamp;
+			m_last_timestamp = timestamp;
+			return std::exchange(m_stage, stage);
+		}
+
+		// Writes the record for the frame that just ended and starts a new one
+		void end_frame(u32 draw_calls);
+	};
+
+	// Attributes the time spent in its scope to a stage, if recording is enabled
+	class frame_stage_scope
+	{
+		frame_timing_recorder& m_recorder;
+		frame_stage m_previous_stage = frame_stage::other;
+		bool m_active;
+
+	public:
+		frame_stage_scope(frame_timing_recorder& recorder, frame_stage stage)
+			: m_recorder(recorder)
+			, m_active(recorder.enabled())
+		{
+			if (m_active)
+			{
+				m_previous_stage = m_recorder.enter(stage);
+			}
+		}
+
+		~frame_stage_scope()
+		{
+			if (m_active)
+			{
+				m_recorder.enter(m_previous_stage);
+			}
+		}
+
+		frame_stage_scope(const frame_stage_scope&) = delete;
+		frame_stage_scope& operator=(const frame_stage_scope&) = delete;
+	};
+}
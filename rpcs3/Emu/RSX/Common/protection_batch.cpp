@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "protection_batch.h"
+#include "Emu/Memory/vm.h"
+
+#include <algorithm>
+#include <set>
+
+namespace rsx
+{
+	thread_local u32 memory_protection_batch::s_depth = 0;
+	thread_local std::vector<memory_protection_batch::request> memory_protection_batch::s_requests;
+
+	atomic_t<u32> memory_protection_batch::s_num_requested{ 0 };
+	atomic_t<u32> memory_protection_batch::s_num_issued{ 0 };
+
+	void memory_protection_batch::protect(const utils::address_range& range, utils::protection prot)
+	{
+		s_num_requested++;
+
+		if (s_depth)
+		{
+			s_requests.push_back({ range.start, u64{ range.end } + 1, prot });
+			return;
+		}
+
+		utils::memory_protect(vm::base(range.start), range.length(), prot);
+		s_num_issued++;
+	}
+
+	void memory_protection_batch::apply()
+	{
+		struct boundary
+		{
+			u64 address;
+			u32 request;
+			bool opens;
+		};
+
+		std::vector<boundary> boundaries;
+		boundaries.reserve(s_requests.size() * 2);
+
+		for (u32 i = 0; i < s_requests.size(); ++i)
+		{
+			boundaries.push_back({ s_requests[i].start, i, true });
+			boundaries.push_back({ s_requests[i].end, i, false });
+		}
+
+		std::sort(boundaries.begin(), boundaries.end(), [](const boundary& a, const boundary& b)
+		{
+			return a.address < b.address;
+		});
+
+		// Sweep the boundaries; within each segment, the most recent request covering it decides the protection
+		std::set<u32> active;
+		u64 run_start = 0;
+		utils::protection run_prot = utils::protection::rw;
+		bool in_run = false;
+
+		auto close_run = [&](u64 run_end)
+		{
+			utils::memory_protect(vm::base(static_cast<u32>(run_start)), run_end - run_start, run_prot);
+			s_num_issued++;
+		};
+
+		for (size_t i = 0; i < boundaries.size();)
+		{
+			const u64 address = boundaries[i].address;
+
+			for (; i < boundaries.size() && boundaries[i].address == address; ++i)
+			{
+				if (boundaries[i].opens)
+				{
+					active.insert(boundaries[i].request);
+				}
+				else
+				{
+					active.erase(boundaries[i].request);
+				}
+			}
+
+			if (active.empty())
+			{
+				if (in_run)
+				{
+					close_run(address);
+					in_run = false;
+				}
+
+				continue;
+			}
+
+			const auto prot = s_requests[*active.rbegin()].prot;
+
+			if (!in_run)
+			{
+				run_start = address;
+				run_prot = prot;
+				in_run = true;
+			}
+			else if (prot != run_prot)
+			{
+				close_run(address);
+				run_start = address;
+				run_prot = prot;
+			}
+		}
+
+		s_requests.clear();
+	}
+}
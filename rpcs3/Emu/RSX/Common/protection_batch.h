@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Utilities/types.h"
+#include "Utilities/Atomic.h"
+#include "Utilities/VirtualMemory.h"
+#include "Utilities/address_range.h"
+
+#include <vector>
+
+namespace rsx
+{
+	/**
+	 * Gathers the page protection changes made on the current thread and applies them with as few calls as possible.
+	 * While a batch is open, requests are only recorded. When the outermost batch closes, they are resolved in submission order,
+	 * later requests overriding earlier ones, and every run of adjacent pages ending up with the same protection is changed with one call.
+	 * A batch must be closed before the lock guarding the protected objects is released, otherwise another thread could find
+	 * an object marked as protected while its pages are not (or the other way around).
+	 */
+	class memory_protection_batch
+	{
+		struct request
+		{
+			u64 start;
+			u64 end; // Exclusive
+			utils::protection prot;
+		};
+
+		static thread_local u32 s_depth;
+		static thread_local std::vector<request> s_requests;
+
+		static atomic_t<u32> s_num_requested;
+		static atomic_t<u32> s_num_issued;
+
+		static void apply();
+
+	public:
+		// Applies the protection immediately, or records it if a batch is open on this thread
+		static void protect(const utils::address_range& range, utils::protection prot);
+
+		static void begin()
+		{
+			s_depth++;
+		}
+
+		static void end()
+		{
+			verify(HERE), s_depth > 0;
+
+			if (--s_depth == 0 && !s_requests.empty())
+			{
+				apply();
+			}
+		}
+
+		static bool is_open()
+		{
+			return s_depth != 0;
+		}
+
+		// Protection changes requested, and system calls actually made, since the last reset
+		static u32 get_num_requested()
+		{
+			return s_num_requested;
+		}
+
+		static u32 get_num_issued()
+		{
+			return s_num_issued;
+		}
+
+		static void reset_statistics()
+		{
+			s_num_requested = 0;
+			s_num_issued = 0;
+		}
+	};
+
+	// Keeps a protection batch open on the current thread for its lifetime
+	class protection_batch_scope
+	{
+	public:
+		protection_batch_scope()
+		{
+			memory_protection_batch::begin();
+		}
+
+		~protection_batch_scope()
+		{
+			memory_protection_batch::end();
+		}
+
+		protection_batch_scope(const protection_batch_scope&) = delete;
+		protection_batch_scope& operator=(const protection_batch_scope&) = delete;
+	};
+}
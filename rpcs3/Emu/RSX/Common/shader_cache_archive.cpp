@@ -0,0 +1,229 @@
+#include "stdafx.h"
+#include "shader_cache_archive.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace rsx
+{
+	shader_cache_archive::~shader_cache_archive()
+	{
+		close();
+	}
+
+	void shader_cache_archive::map(u64 size)
+	{
+		if (!size)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		m_mapping_handle = CreateFileMappingW(m_file.get_handle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		m_mapping = m_mapping_handle ? static_cast<const u8*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, size)) : nullptr;
+#else
+		void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, m_file.get_handle(), 0);
+		m_mapping = ptr != MAP_FAILED ? static_cast<const u8*>(ptr) : nullptr;
+#endif
+
+		if (m_mapping)
+		{
+			m_mapping_size = size;
+		}
+	}
+
+	void shader_cache_archive::unmap()
+	{
+#ifdef _WIN32
+		if (m_mapping)
+		{
+			UnmapViewOfFile(m_mapping);
+		}
+
+		if (m_mapping_handle)
+		{
+			CloseHandle(m_mapping_handle);
+			m_mapping_handle = nullptr;
+		}
+#else
+		if (m_mapping)
+		{
+			::munmap(const_cast<u8*>(m_mapping), m_mapping_size);
+		}
+#endif
+
+		m_mapping = nullptr;
+		m_mapping_size = 0;
+	}
+
+	bool shader_cache_archive::open(const std::string& path)
+	{
+		close();
+
+		if (!m_file.open(path, fs::read + fs::write + fs::create + fs::lock))
+		{
+			LOG_ERROR(RSX, "Shader cache archive %s could not be opened (%s)", path, fs::g_tls_error);
+			return false;
+		}
+
+		m_path = path;
+
+		archive_header header{};
+		const u64 file_size = m_file.size();
+
+		if (file_size < sizeof(archive_header) || !m_file.read(header) || header.magic != archive_magic || header.version != archive_version)
+		{
+			if (file_size)
+			{
+				LOG_WARNING(RSX, "Shader cache archive %s is not compatible with this version and will be recreated", path);
+			}
+
+			header = { archive_magic, archive_version };
+			m_file.trunc(0);
+			m_file.seek(0);
+			m_file.write(header);
+			m_end_offset = sizeof(archive_header);
+			return true;
+		}
+
+		map(file_size);
+
+		if (!m_mapping)
+		{
+			LOG_ERROR(RSX, "Shader cache archive %s could not be mapped", path);
+			m_file.close();
+			return false;
+		}
+
+		// Walk the record headers; stop at the first record that does not fit in the file
+		u64 offset = sizeof(archive_header);
+
+		while (offset + sizeof(record_header) <= m_mapping_size)
+		{
+			record_header record;
+			std::memcpy(&record, m_mapping + offset, sizeof(record_header));
+
+			const u64 payload_offset = offset + sizeof(record_header);
+			const u64 next_offset = payload_offset + ::align<u64>(record.size, 8);
+
+			if (record.type > object_type::decompiled_fragment_program || next_offset > m_mapping_size)
+			{
+				break;
+			}
+
+			m_index[record.type].emplace(record.key, record_info{ payload_offset, record.size });
+			m_mapped_records.emplace_back(payload_offset, record);
+			offset = next_offset;
+		}
+
+		m_end_offset = offset;
+
+		if (m_end_offset != file_size)
+		{
+			LOG_WARNING(RSX, "Shader cache archive %s has %llu bytes of incomplete data at the end, discarding", path, file_size - m_end_offset);
+
+			// Mapped files cannot be shrunk on all platforms, remap after truncating
+			unmap();
+			m_file.trunc(m_end_offset);
+			map(m_end_offset);
+
+			if (!m_mapping && m_end_offset > sizeof(archive_header))
+			{
+				LOG_ERROR(RSX, "Shader cache archive %s could not be mapped", path);
+				close();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void shader_cache_archive::close()
+	{
+		std::lock_guard lock(m_mutex);
+
+		unmap();
+		m_file.close();
+		m_mapped_records.clear();
+		for (auto& index : m_index)
+		{
+			index.clear();
+		}
+		m_end_offset = 0;
+	}
+
+	bool shader_cache_archive::contains(object_type type, u64 key) const
+	{
+		reader_lock lock(m_mutex);
+		return m_index[type].count(key) != 0;
+	}
+
+	bool shader_cache_archive::read(object_type type, u64 key, std::vector<u8>& data) const
+	{
+		{
+			reader_lock lock(m_mutex);
+
+			const auto found = m_index[type].find(key);
+			if (found == m_index[type].end())
+			{
+				return false;
+			}
+
+			const auto& info = found->second;
+
+			if (info.offset + info.size <= m_mapping_size)
+			{
+				data.resize(info.size);
+				std::memcpy(data.data(), m_mapping + info.offset, info.size);
+				return true;
+			}
+		}
+
+		// Stored after the archive was mapped, the file position needs exclusive access
+		std::lock_guard lock(m_mutex);
+
+		const auto found = m_index[type].find(key);
+		if (found == m_index[type].end())
+		{
+			return false;
+		}
+
+		const auto& info = found->second;
+		data.resize(info.size);
+
+		m_file.seek(info.offset);
+		return m_file.read(data.data(), info.size) == info.size;
+	}
+
+	bool shader_cache_archive::append(object_type type, u64 key, const void* data, u32 size)
+	{
+		std::lock_guard lock(m_mutex);
+
+		if (!m_file || m_index[type].count(key))
+		{
+			return false;
+		}
+
+		// Header and payload are written in one go so that an interrupted write only ever leaves a torn tail
+		std::vector<u8> record(sizeof(record_header) + ::align<u64>(size, 8));
+		const record_header header = { key, type, size };
+		std::memcpy(record.data(), &header, sizeof(record_header));
+		std::memcpy(record.data() + sizeof(record_header), data, size);
+
+		m_file.seek(m_end_offset);
+
+		if (m_file.write(record.data(), record.size()) != record.size())
+		{
+			LOG_ERROR(RSX, "Shader cache archive %s: write failed (%s)", m_path, fs::g_tls_error);
+			m_file.trunc(m_end_offset);
+			return false;
+		}
+
+		m_index[type].emplace(key, record_info{ m_end_offset + sizeof(record_header), size });
+		m_end_offset += record.size();
+		return true;
+	}
+}
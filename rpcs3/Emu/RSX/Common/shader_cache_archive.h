@@ -0,0 +1,220 @@
+#pragma once
+
+#include "Utilities/types.h"
+#include "Utilities/File.h"
+#include "Utilities/mutex.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace rsx
+{
+	/**
+	 * Append-only container for the small objects making up the on-disk shader cache.
+	 * Objects are identified by a (type, key) pair and are never rewritten once stored.
+	 * On open, the file is mapped read-only and its record headers are walked to build the index,
+	 * so a cache holding tens of thousands of objects is loaded without one filesystem round trip per object.
+	 */
+	class shader_cache_archive
+	{
+		struct archive_header
+		{
+			u32 magic;
+			u32 version;
+		};
+
+		struct record_header
+		{
+			u64 key;
+			u32 type;
+			u32 size;
+		};
+
+		struct record_info
+		{
+			u64 offset; // Offset of the payload in the file
+			u32 size;
+		};
+
+		static constexpr u32 archive_magic = "RSXC"_u32;
+		static constexpr u32 archive_version = 1;
+
+		fs::file m_file;
+		std::string m_path;
+
+		const u8* m_mapping = nullptr;
+		u64 m_mapping_size = 0;
+#ifdef _WIN32
+		void* m_mapping_handle = nullptr;
+#endif
+
+		// Records present in the mapping, in file order
+		std::vector<std::pair<u64, record_header>> m_mapped_records;
+
+		std::unordered_map<u64, record_info> m_index[5];
+		u64 m_end_offset = 0;
+
+		mutable shared_mutex m_mutex;
+
+		void map(u64 size);
+		void unmap();
+
+	public:
+		// Object classes; each has its own key space
+		enum object_type : u32
+		{
+			vertex_program = 0,
+			fragment_program = 1,
+			pipeline = 2,
+			decompiled_vertex_program = 3,
+			decompiled_fragment_program = 4,
+		};
+
+		// Builds an object payload out of trivially copyable values, strings and vectors
+		class object_writer
+		{
+			std::vector<u8> m_data;
+
+		public:
+			template <typename T>
+			void write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+				const auto pos = m_data.size();
+				m_data.resize(pos + sizeof(T));
+				std::memcpy(m_data.data() + pos, &value, sizeof(T));
+			}
+
+			template <typename T>
+			void write(const std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+				write(::size32(values));
+				const auto pos = m_data.size();
+				m_data.resize(pos + values.size() * sizeof(T));
+				std::memcpy(m_data.data() + pos, values.data(), values.size() * sizeof(T));
+			}
+
+			void write(const std::string& str)
+			{
+				write(::size32(str));
+				m_data.insert(m_data.end(), str.begin(), str.end());
+			}
+
+			const std::vector<u8>& data() const
+			{
+				return m_data;
+			}
+		};
+
+		// Reads back a payload built by object_writer; any out-of-bounds read marks the reader as failed
+		class object_reader
+		{
+			const std::vector<u8>& m_data;
+			size_t m_pos = 0;
+			bool m_failed = false;
+
+			bool check(size_t size)
+			{
+				m_failed |= (m_data.size() - m_pos) < size;
+				return !m_failed;
+			}
+
+		public:
+			object_reader(const std::vector<u8>& data)
+				: m_data(data)
+			{}
+
+			template <typename T>
+			void read(T& value)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+				if (check(sizeof(T)))
+				{
+					std::memcpy(&value, m_data.data() + m_pos, sizeof(T));
+					m_pos += sizeof(T);
+				}
+			}
+
+			template <typename T>
+			void read(std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+				u32 count = 0;
+				read(count);
+
+				if (check(size_t{ count } * sizeof(T)))
+				{
+					values.resize(count);
+					std::memcpy(values.data(), m_data.data() + m_pos, size_t{ count } * sizeof(T));
+					m_pos += size_t{ count } * sizeof(T);
+				}
+			}
+
+			void read(std::string& str)
+			{
+				u32 length = 0;
+				read(length);
+
+				if (check(length))
+				{
+					str.assign(reinterpret_cast<const char*>(m_data.data() + m_pos), length);
+					m_pos += length;
+				}
+			}
+
+			size_t remaining() const
+			{
+				return m_data.size() - m_pos;
+			}
+
+			// True if every read succeeded and the whole payload was consumed
+			bool valid() const
+			{
+				return !m_failed && m_pos == m_data.size();
+			}
+		};
+
+		shader_cache_archive() = default;
+		shader_cache_archive(const shader_cache_archive&) = delete;
+		shader_cache_archive& operator=(const shader_cache_archive&) = delete;
+		~shader_cache_archive();
+
+		// Opens or creates the archive. A torn record left at the end of the file by an interrupted write is discarded.
+		bool open(const std::string& path);
+		void close();
+
+		bool is_open() const
+		{
+			return !!m_file;
+		}
+
+		bool contains(object_type type, u64 key) const;
+
+		// Reads an object into data, returns false if it is not in the archive
+		bool read(object_type type, u64 key, std::vector<u8>& data) const;
+
+		// Stores an object unless an object with the same key already exists
+		bool append(object_type type, u64 key, const void* data, u32 size);
+
+		// Visits every object of the given type that was present when the archive was opened, in storage order
+		template <typename F>
+		void for_each(object_type type, F&& func) const
+		{
+			for (const auto& record : m_mapped_records)
+			{
+				if (record.second.type == type)
+				{
+					func(record.second.key, m_mapping + record.first, record.second.size);
+				}
+			}
+		}
+
+		u32 size(object_type type) const
+		{
+			reader_lock lock(m_mutex);
+			return ::size32(m_index[type]);
+		}
+	};
+}
@@ -52,14 +52,90 @@ namespace rsx
 		using surface_overlap_info = surface_overlap_info_t<surface_type>;
 
 	protected:
+		/**
+		 * Address-ordered view of a surface pool, used to answer overlap queries without walking every surface.
+		 * The range of a surface can only change when the pool is modified or when the surface is rebound,
+		 * so the index is marked dirty by those paths and rebuilt by the next query.
+		 */
+		struct surface_range_index
+		{
+			struct entry
+			{
+				u32 start;
+				u32 end; // Inclusive
+				surface_type surface;
+			};
+
+			std::vector<entry> entries;
+			u32 max_length = 0;
+			bool dirty = true;
+
+			void rebuild(const std::unordered_map<u32, surface_storage_type>& data)
+			{
+				entries.clear();
+				max_length = 0;
+
+				for (const auto& e : data)
+				{
+					auto surface = Traits::get(e.second);
+					const u32 length = surface->get_rsx_pitch() * surface->get_surface_height(rsx::surface_metrics::samples);
+
+					entries.push_back({ e.first, e.first + std::max(length, 1u) - 1, surface });
+					max_length = std::max(max_length, length);
+				}
+
+				std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b)
+				{
+					return a.start < b.start;
+				});
+
+				dirty = false;
+			}
+
+			// Calls func(base_address, surface) for every surface whose memory overlaps range
+			template <typename F>
+			void for_each_overlapping(const rsx::address_range& range, F&& func) const
+			{
+				// Nothing starting more than max_length bytes before the range can reach into it
+				const u32 first_start = (range.start > max_length) ? (range.start - max_length) : 0;
+
+				auto It = std::lower_bound(entries.begin(), entries.end(), first_start, [](const entry& e, u32 value)
+				{
+					return e.start < value;
+				});
+
+				for (; It != entries.end() && It->start <= range.end; ++It)
+				{
+					if (It->end >= range.start)
+					{
+						func(It->start, It->surface);
+					}
+				}
+			}
+		};
+
 		std::unordered_map<u32, surface_storage_type> m_render_targets_storage = {};
 		std::unordered_map<u32, surface_storage_type> m_depth_stencil_storage = {};
 
 		rsx::address_range m_render_targets_memory_range;
 		rsx::address_range m_depth_stencil_memory_range;
 
+		surface_range_index m_render_targets_index;
+		surface_range_index m_depth_stencil_index;
+
+		// Scratch storage reused by the overlap queries
+		std::vector<std::pair<u32, surface_type>> m_intersect_scratch;
+		std::vector<std::pair<u32, bool>> m_dirty_scratch;
+		std::vector<surface_overlap_info> m_overlap_scratch;
+
 		bool m_invalidate_on_write = false;
 
+		void notify_storage_changed()
+		{
+			m_render_targets_index.dirty = true;
+			m_depth_stencil_index.dirty = true;
+		}
+
 	public:
 		std::pair<u8, u8> m_bound_render_targets_config = {};
 		std::array<std::pair<u32, surface_type>, 4> m_bound_render_targets = {};
@@ -116,6 +192,7 @@ namespace rsx
 				verify(HERE), region.target == Traits::get(sink);
 				orphaned_surfaces.push_back(region.target);
 				data[new_address] = std::move(sink);
+				notify_storage_changed();
 			};
 
 			// Define incoming region
@@ -188,93 +265,61 @@ namespace rsx
 		template <bool is_depth_surface>
 		void intersect_surface_region(command_list_type cmd, u32 address, surface_type new_surface, surface_type prev_surface)
 		{
-			auto scan_list = [&new_surface, address](const rsx::address_range& mem_range, u64 timestamp_check,
-				std::unordered_map<u32, surface_storage_type>& data) -> std::vector<std::pair<u32, surface_type>>
+			const rsx::address_range mem_range = new_surface->get_memory_range();
+			const u64 timestamp_check = prev_surface ? prev_surface->last_use_tag : new_surface->last_use_tag;
+
+			auto& surface_info = m_intersect_scratch;
+			surface_info.clear();
+
+			auto scan_list = [&](surface_range_index& index, const std::unordered_map<u32, surface_storage_type>& data)
 			{
-				std::vector<std::pair<u32, surface_type>> result;
-				for (const auto &e : data)
+				if (index.dirty)
 				{
-					auto surface = Traits::get(e.second);
+					index.rebuild(data);
+				}
 
-					if (e.second->last_use_tag <= timestamp_check ||
+				index.for_each_overlapping(mem_range, [&](u32 base_address, surface_type surface)
+				{
+					if (surface->last_use_tag <= timestamp_check ||
 						new_surface == surface ||
-						address == e.first ||
-						e.second->dirty())
+						address == base_address ||
+						surface->dirty())
 					{
 						// Do not bother synchronizing with uninitialized data
-						continue;
+						return;
 					}
 
 					// Memory partition check
 					if (mem_range.start >= constants::local_mem_base)
 					{
-						if (e.first < constants::local_mem_base) continue;
+						if (base_address < constants::local_mem_base) return;
 					}
 					else
 					{
-						if (e.first >= constants::local_mem_base) continue;
+						if (base_address >= constants::local_mem_base) return;
 					}
 
 					// Pitch check
 					if (!rsx::pitch_compatible(surface, new_surface))
 					{
-						continue;
-					}
-
-					// Range check
-					const rsx::address_range this_range = surface->get_memory_range();
-					if (!this_range.overlaps(mem_range))
-					{
-						continue;
+						return;
 					}
 
-					result.push_back({ e.first, surface });
-				}
-
-				return result;
+					surface_info.push_back({ base_address, surface });
+				});
 			};
 
-			const rsx::address_range mem_range = new_surface->get_memory_range();
-			const u64 timestamp_check = prev_surface ? prev_surface->last_use_tag : new_surface->last_use_tag;
-
-			auto list1 = scan_list(mem_range, timestamp_check, m_render_targets_storage);
-			auto list2 = scan_list(mem_range, timestamp_check, m_depth_stencil_storage);
+			scan_list(m_render_targets_index, m_render_targets_storage);
+			scan_list(m_depth_stencil_index, m_depth_stencil_storage);
 
 			if (prev_surface)
 			{
 				// Append the previous removed surface to the intersection list
-				if constexpr (is_depth_surface)
-				{
-					list2.push_back({ address, prev_surface });
-				}
-				else
-				{
-					list1.push_back({ address, prev_surface });
-				}
+				surface_info.push_back({ address, prev_surface });
 			}
-			else
+			else if (surface_info.empty())
 			{
-				if (list1.empty() && list2.empty())
-				{
-					return;
-				}
-			}
-
-			std::vector<std::pair<u32, surface_type>> surface_info;
-			if (list1.empty())
-			{
-				surface_info = std::move(list2);
-			}
-			else if (list2.empty())
-			{
-				surface_info = std::move(list1);
-			}
-			else
-			{
-				surface_info = std::move(list1);
-				surface_info.reserve(list1.size() + list2.size());
-
-				for (const auto& e : list2) surface_info.push_back(e);
+				return;
 			}
 
 			if (UNLIKELY(surface_info.size() > 1))
@@ -376,9 +421,14 @@ namespace rsx
 				if (Traits::surface_matches_properties(surface, format, width, height, antialias))
 				{
 					if (pitch_compatible)
+					{
 						Traits::notify_surface_persist(surface);
+					}
 					else
+					{
 						Traits::invalidate_surface_contents(command_list, Traits::get(surface), address, pitch);
+						notify_storage_changed();
+					}
 
 					Traits::prepare_surface_for_drawing(command_list, Traits::get(surface));
 					new_surface = Traits::get(surface);
@@ -389,6 +439,7 @@ namespace rsx
 					old_surface = Traits::get(surface);
 					old_surface_storage = std::move(surface);
 					primary_storage->erase(It);
+					notify_storage_changed();
 				}
 			}
 
@@ -454,6 +505,7 @@ namespace rsx
 					Traits::notify_surface_invalidated(aliased_surface->second);
 					invalidated_resources.push_back(std::move(aliased_surface->second));
 					secondary_storage->erase(aliased_surface);
+					notify_storage_changed();
 				}
 			}
 
@@ -471,6 +523,7 @@ namespace rsx
 			{
 				// New surface was found among invalidated surfaces or created from scratch
 				(*primary_storage)[address] = std::move(new_surface_storage);
+				notify_storage_changed();
 			}
 
 			verify(HERE), new_surface->get_spp() == get_format_sample_count(antialias);
@@ -636,6 +689,7 @@ namespace rsx
 					Traits::notify_surface_invalidated(It->second);
 					invalidated_resources.push_back(std::move(It->second));
 					m_render_targets_storage.erase(It);
+					notify_storage_changed();
 
 					cache_tag = rsx::get_shared_tag();
 					return;
@@ -649,6 +703,7 @@ namespace rsx
 					Traits::notify_surface_invalidated(It->second);
 					invalidated_resources.push_back(std::move(It->second));
 					m_depth_stencil_storage.erase(It);
+					notify_storage_changed();
 
 					cache_tag = rsx::get_shared_tag();
 					return;
@@ -669,34 +724,40 @@ namespace rsx
 			return (m_bound_depth_stencil.first == address);
 		}
 
+		/**
+		 * Returns the surfaces overlapping the given texture region, oldest first.
+		 * The returned list is scratch storage owned by the surface store and is only valid until the next call.
+		 */
 		template <typename commandbuffer_type>
-		std::vector<surface_overlap_info> get_merged_texture_memory_region(commandbuffer_type& cmd, u32 texaddr, u32 required_width, u32 required_height, u32 required_pitch, u8 required_bpp)
+		const std::vector<surface_overlap_info>& get_merged_texture_memory_region(commandbuffer_type& cmd, u32 texaddr, u32 required_width, u32 required_height, u32 required_pitch, u8 required_bpp)
 		{
-			std::vector<surface_overlap_info> result;
-			std::vector<std::pair<u32, bool>> dirty;
+			auto& result = m_overlap_scratch;
+			auto& dirty = m_dirty_scratch;
+			result.clear();
+			dirty.clear();
+
 			const u32 limit = texaddr + (required_pitch * required_height);
 
-			auto process_list_function = [&](std::unordered_map<u32, surface_storage_type>& data, bool is_depth)
+			// Range test helper to quickly discard blocks
+			// Fortunately, render targets tend to be clustered anyway
+			rsx::address_range test = rsx::address_range::start_end(texaddr, limit-1);
+
+			auto process_list_function = [&](surface_range_index& index, const std::unordered_map<u32, surface_storage_type>& data, bool is_depth)
 			{
-				for (auto &tex_info : data)
+				if (index.dirty)
 				{
-					const auto this_address = tex_info.first;
-					if (this_address >= limit)
-						continue;
+					index.rebuild(data);
+				}
 
-					auto surface = tex_info.second.get();
-					const auto pitch = surface->get_rsx_pitch();
+				index.for_each_overlapping(test, [&](u32 this_address, surface_type surface)
+				{
 					if (!rsx::pitch_compatible(surface, required_pitch, required_height))
-						continue;
-
-					const auto texture_size = pitch * surface->get_surface_height(rsx::surface_metrics::samples);
-					if ((this_address + texture_size) <= texaddr)
-						continue;
+						return;
 
 					if (surface->read_barrier(cmd); !surface->test())
 					{
 						dirty.emplace_back(this_address, is_depth);
-						continue;
+						return;
 					}
 
 					surface_overlap_info info;
@@ -716,7 +777,7 @@ namespace rsx
 						if (UNLIKELY(info.dst_x >= required_width || info.dst_y >= required_height))
 						{
 							// Out of bounds
-							continue;
+							return;
 						}
 
 						info.src_x = 0;
@@ -734,7 +795,7 @@ namespace rsx
 						{
 							// Region lies outside the actual texture area, but inside the 'tile'
 							// In this case, a small region lies to the top-left corner, partially occupying the  target
-							continue;
+							return;
 						}
 
 						info.dst_x = 0;
@@ -753,21 +814,17 @@ namespace rsx
 					}
 
 					result.push_back(info);
-				}
+				});
 			};
 
-			// Range test helper to quickly discard blocks
-			// Fortunately, render targets tend to be clustered anyway
-			rsx::address_range test = rsx::address_range::start_end(texaddr, limit-1);
-
 			if (test.overlaps(m_render_targets_memory_range))
 			{
-				process_list_function(m_render_targets_storage, false);
+				process_list_function(m_render_targets_index, m_render_targets_storage, false);
 			}
 
 			if (test.overlaps(m_depth_stencil_memory_range))
 			{
-				process_list_function(m_depth_stencil_storage, true);
+				process_list_function(m_depth_stencil_index, m_depth_stencil_storage, true);
 			}
 
 			if (!dirty.empty())
@@ -880,6 +937,7 @@ namespace rsx
 
 			free_resource_list(m_render_targets_storage);
 			free_resource_list(m_depth_stencil_storage);
+			notify_storage_changed();
 
 			m_bound_depth_stencil = std::make_pair(0, nullptr);
 			m_bound_render_targets_config = { 0, 0 };
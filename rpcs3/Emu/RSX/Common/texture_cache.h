@@ -124,13 +124,24 @@ namespace rsx
 #endif // TEXTURE_CACHE_DEBUG
 		};
 
+		using section_list_pool = scratch_vector_pool<section_storage_type*>;
+		using section_list = typename section_list_pool::lease;
+
 		struct intersecting_set
 		{
-			std::vector<section_storage_type*> sections = {};
+			section_list sections;
 			address_range invalidate_range = {};
 			bool has_flushables = false;
 		};
 
+		// Preserves the age ordering of surface cache and local resources when merging them
+		struct sort_helper
+		{
+			u64 tag;   // Timestamp
+			u32 list;  // List source, 0 = fbo, 1 = local
+			u32 index; // Index in list
+		};
+
 		enum surface_transform : u32
 		{
 			identity = 0,
@@ -334,14 +345,23 @@ namespace rsx
 		std::unordered_map<address_range, section_storage_type*> m_flush_always_cache;
 		u64 m_flush_always_update_timestamp = 0;
 
+		//Speculative readbacks not yet staged to host memory, with the sync timestamp of the transfer
+		std::vector<std::pair<section_storage_type*, u64>> m_pending_readbacks;
+
 		//Memory usage
 		const u32 m_max_zombie_objects = 64; //Limit on how many texture objects to keep around for reuse after they are invalidated
 
+		//Reusable storage for lookup results
+		section_list_pool m_section_list_pool;
+		scratch_vector_pool<sort_helper> m_sort_list_pool;
+
 		//Other statistics
 		std::atomic<u32> m_flushes_this_frame = { 0 };
 		std::atomic<u32> m_misses_this_frame  = { 0 };
 		std::atomic<u32> m_speculations_this_frame = { 0 };
 		std::atomic<u32> m_unavoidable_hard_faults_this_frame = { 0 };
+		std::atomic<u32> m_hash_verification_misses_this_frame = { 0 };
+		std::atomic<u32> m_staged_readbacks_this_frame = { 0 };
 		static const u32 m_predict_max_flushes_per_frame = 50; // Above this number the predictions are disabled
 
 		// Invalidation
@@ -586,6 +606,12 @@ namespace rsx
 				u32 no_access_count = 0;
 				for (const auto &excluded : data.sections_to_exclude)
 				{
+					if (excluded->is_hash_guarded())
+					{
+						// Does not rely on page protection, its pages can be released with the rest
+						continue;
+					}
+
 					address_range exclusion_range = excluded->get_locked_range();
 
 					// We need to make sure that the exclusion range is *inside* invalidate range
@@ -620,7 +646,7 @@ namespace rsx
 				{
 					for (auto &exclusion : data.sections_to_exclude)
 					{
-						if (exclusion->get_protection() != utils::protection::ro)
+						if (exclusion->get_protection() != utils::protection::ro && !exclusion->is_hash_guarded())
 						{
 							ranges_to_protect_ro.exclude(exclusion->get_locked_range());
 						}
@@ -665,7 +691,7 @@ namespace rsx
 
 			const u64 cache_tag = ++m_last_section_cache_tag;
 
-			intersecting_set result = {};
+			intersecting_set result{ m_section_list_pool.acquire() };
 			address_range &invalidate_range = result.invalidate_range;
 			invalidate_range = fault_range; // Sections fully inside this range will be invalidated, others will be deemed false positives
 
@@ -716,7 +742,7 @@ namespace rsx
 
 						// Add texture to result, and update its cache tag
 						tex.cache_tag = cache_tag;
-						result.sections.push_back(&tex);
+						result.sections->push_back(&tex);
 
 						if (tex.is_flushable())
 						{
@@ -768,6 +794,9 @@ namespace rsx
 			AUDIT(fault_range_in.valid());
 			address_range fault_range = fault_range_in.to_page_range();
 
+			// Flushing and unprotecting touch many adjacent ranges, apply them together on exit
+			protection_batch_scope protection_batch;
+
 			intersecting_set trampled_set = std::move(get_intersecting_set(fault_range));
 
 			thrashed_set result = {};
@@ -1018,6 +1047,7 @@ namespace rsx
 		{
 			m_storage.clear();
 			m_predictor.clear();
+			m_pending_readbacks.clear();
 		}
 
 		virtual void on_frame_end()
@@ -1027,10 +1057,11 @@ namespace rsx
 			reset_frame_statistics();
 		}
 
+		// The returned list is scratch storage and should not outlive the lookup
 		template <bool check_unlocked = false>
-		std::vector<section_storage_type*> find_texture_from_range(const address_range &test_range, u16 required_pitch = 0, u32 context_mask = 0xFF)
+		section_list find_texture_from_range(const address_range &test_range, u16 required_pitch = 0, u32 context_mask = 0xFF)
 		{
-			std::vector<section_storage_type*> results;
+			auto results = m_section_list_pool.acquire();
 
 			for (auto It = m_storage.range_begin(test_range, full_range); It != m_storage.range_end(); It++)
 			{
@@ -1049,13 +1080,69 @@ namespace rsx
 						continue;
 					}
 
-					results.push_back(&tex);
+					results->push_back(&tex);
 				}
 			}
 
 			return results;
 		}
 
+		// Discards hash-verified sections in range whose memory was written since they were locked
+		// Sections whose memory has stayed unchanged for long enough are put back under page protection
+		void discard_modified_hash_guarded_sections(reader_lock& lock, const address_range &range)
+		{
+			auto modified = m_section_list_pool.acquire();
+			auto stable = m_section_list_pool.acquire();
+
+			for (auto It = m_storage.range_begin(range, full_range, true); It != m_storage.range_end(); It++)
+			{
+				auto &tex = *It;
+
+				if (!tex.is_hash_guarded())
+				{
+					continue;
+				}
+
+				if (!tex.test_content_hash())
+				{
+					modified->push_back(&tex);
+				}
+				else if (tex.record_clean_hash_check())
+				{
+					stable->push_back(&tex);
+				}
+			}
+
+			if (modified.empty() && stable.empty())
+			{
+				return;
+			}
+
+			lock.upgrade();
+
+			for (auto &tex : *modified)
+			{
+				// The section could have been invalidated while the lock was being upgraded
+				if (tex->is_hash_guarded())
+				{
+					tex->discard();
+					m_hash_verification_misses_this_frame++;
+				}
+			}
+
+			for (auto &tex : *stable)
+			{
+				// The memory could have been written after the check, it's tested again once the pages are protected
+				if (tex->is_hash_guarded() && !tex->end_hash_verification())
+				{
+					tex->discard();
+					m_hash_verification_misses_this_frame++;
+				}
+			}
+
+			update_cache_tag();
+		}
+
 		template <bool check_unlocked = false>
 		section_storage_type *find_texture_from_dimensions(u32 rsx_address, u32 format, u16 width = 0, u16 height = 0, u16 depth = 0, u16 mipmaps = 0)
 		{
@@ -1185,6 +1272,7 @@ namespace rsx
 			AUDIT(g_cfg.video.write_color_buffers || g_cfg.video.write_depth_buffer); // this method is only called when either WCB or WDB are enabled
 
 			std::lock_guard lock(m_cache_mutex);
+			protection_batch_scope protection_batch;
 
 			// Find a cached section to use
 			section_storage_type& region = *find_cached_texture(rsx_range, true, true, width, height);
@@ -1371,6 +1459,8 @@ namespace rsx
 
 			if (m_cache_update_tag.load(std::memory_order_consume) == data.cache_tag)
 			{
+				protection_batch_scope protection_batch;
+
 				//1. Write memory to cpu side
 				flush_set(cmd, data, std::forward<Args>(extras)...);
 
@@ -1421,6 +1511,11 @@ namespace rsx
 				region.copy_texture(cmd, false, std::forward<Args>(extras)...);
 				result = true;
 
+				if (g_cfg.video.stage_speculative_readbacks)
+				{
+					m_pending_readbacks.emplace_back(&region, region.get_sync_timestamp());
+				}
+
 				cur_flushes_this_frame++;
 				if (cur_flushes_this_frame > m_predict_max_flushes_per_frame)
 					return result;
@@ -1429,6 +1524,58 @@ namespace rsx
 			return result;
 		}
 
+		// Copies the speculative readbacks that have completed on the GPU to host memory.
+		// Must be called from the thread owning the graphics context, outside of draw calls.
+		void stage_completed_readbacks()
+		{
+			if (m_pending_readbacks.empty())
+				return;
+
+			std::lock_guard lock(m_cache_mutex);
+
+			u32 num_staged = 0;
+			for (auto It = m_pending_readbacks.begin(); It != m_pending_readbacks.end();)
+			{
+				auto section = It->first;
+
+				if (!section->is_locked() || !section->is_synchronized() || section->is_flushed() || section->get_sync_timestamp() != It->second)
+				{
+					// Flushed, invalidated or reused since the transfer was started
+					It = m_pending_readbacks.erase(It);
+					continue;
+				}
+
+				if (section->begin_readback_staging())
+				{
+					It->second = 0;
+					num_staged++;
+				}
+
+				++It;
+			}
+
+			if (!num_staged)
+				return;
+
+			// The readback buffers stay mapped until the copies are done
+			g_dma_manager.sync();
+
+			for (auto It = m_pending_readbacks.begin(); It != m_pending_readbacks.end();)
+			{
+				if (It->second == 0)
+				{
+					It->first->finish_readback_staging();
+					It = m_pending_readbacks.erase(It);
+				}
+				else
+				{
+					++It;
+				}
+			}
+
+			m_staged_readbacks_this_frame += num_staged;
+		}
+
 		void purge_unreleased_sections()
 		{
 			std::lock_guard lock(m_cache_mutex);
@@ -1555,16 +1702,9 @@ namespace rsx
 			const surface_store_list_type& fbos, const std::vector<section_storage_type*>& local,
 			u32 texaddr, u16 slice_w, u16 slice_h, u16 src_padding, u16 pitch, u16 count, u8 bpp, bool is_depth)
 		{
-			// Need to preserve sorting order
-			struct sort_helper
-			{
-				u64 tag;   // Timestamp
-				u32 list;  // List source, 0 = fbo, 1 = local
-				u32 index; // Index in list
-			};
-
 			std::vector<copy_region_descriptor> surfaces;
-			std::vector<sort_helper> sort_list;
+			auto sort_list_storage = m_sort_list_pool.acquire();
+			auto& sort_list = *sort_list_storage;
 			const u16 src_slice_h = slice_h + src_padding;
 
 			if (!fbos.empty() && !local.empty())
@@ -2046,12 +2186,20 @@ namespace rsx
 
 			reader_lock lock(m_cache_mutex);
 
+			if (g_cfg.video.hash_verified_textures)
+			{
+				// Sections without page protection are only known to be stale once their contents are checked
+				discard_modified_hash_guarded_sections(lock, tex_range);
+			}
+
 			if (LIKELY(is_compressed_format))
 			{
 				// Most mesh textures are stored as compressed to make the most of the limited memory
 				if (auto cached_texture = find_texture_from_dimensions(texaddr, format, tex_width, tex_height, depth))
 				{
-					return{ cached_texture->get_view(tex.remap(), tex.decoded_remap()), cached_texture->get_context(), cached_texture->is_depth_texture(), scale_x, scale_y, cached_texture->get_image_type() };
+					sampled_image_descriptor result = { cached_texture->get_view(tex.remap(), tex.decoded_remap()), cached_texture->get_context(), cached_texture->is_depth_texture(), scale_x, scale_y, cached_texture->get_image_type() };
+					result.is_hash_verified = cached_texture->is_hash_guarded();
+					return result;
 				}
 			}
 			else
@@ -2077,7 +2225,9 @@ namespace rsx
 				{
 					if (cached_texture->matches(texaddr, format, tex_width, tex_height, depth, 0))
 					{
-						return{ cached_texture->get_view(tex.remap(), tex.decoded_remap()), cached_texture->get_context(), cached_texture->is_depth_texture(), scale_x, scale_y, cached_texture->get_image_type() };
+						sampled_image_descriptor result = { cached_texture->get_view(tex.remap(), tex.decoded_remap()), cached_texture->get_context(), cached_texture->is_depth_texture(), scale_x, scale_y, cached_texture->get_image_type() };
+						result.is_hash_verified = cached_texture->is_hash_guarded();
+						return result;
 					}
 				}
 
@@ -2086,7 +2236,7 @@ namespace rsx
 				// NOTE: Compressed formats require a reupload, facilitated by blit synchronization and/or WCB and are not handled here
 
 				const auto bpp = get_format_block_size_in_bytes(format);
-				const auto overlapping_fbos = m_rtts.get_merged_texture_memory_region(cmd, texaddr, tex_width, required_surface_height, tex_pitch, bpp);
+				const auto& overlapping_fbos = m_rtts.get_merged_texture_memory_region(cmd, texaddr, tex_width, required_surface_height, tex_pitch, bpp);
 
 				if (!overlapping_fbos.empty() || !overlapping_locals.empty())
 				{
@@ -2214,6 +2364,9 @@ namespace rsx
 							}
 						}
 
+						result.is_hash_verified = std::any_of(overlapping_locals.begin(), overlapping_locals.end(),
+							[](const section_storage_type* section) { return section->is_hash_guarded(); });
+
 						return result;
 					}
 #ifdef TEXTURE_CACHE_DEBUG
@@ -2254,9 +2407,13 @@ namespace rsx
 			invalidate_range_impl_base(cmd, tex_range, invalidation_cause::read, std::forward<Args>(extras)...);
 
 			//NOTE: SRGB correction is to be handled in the fragment shader; upload as linear RGB
-			return{ upload_image_from_cpu(cmd, tex_range, tex_width, tex_height, depth, tex.get_exact_mipmap_count(), tex_pitch, format,
-				texture_upload_context::shader_read, subresources_layout, extended_dimension, is_swizzled)->get_view(tex.remap(), tex.decoded_remap()),
+			const auto uploaded = upload_image_from_cpu(cmd, tex_range, tex_width, tex_height, depth, tex.get_exact_mipmap_count(), tex_pitch, format,
+				texture_upload_context::shader_read, subresources_layout, extended_dimension, is_swizzled);
+
+			sampled_image_descriptor result = { uploaded->get_view(tex.remap(), tex.decoded_remap()),
 				texture_upload_context::shader_read, is_depth_format, scale_x, scale_y, extended_dimension };
+			result.is_hash_verified = uploaded->is_hash_guarded();
+			return result;
 		}
 
 		template <typename surface_store_type, typename blitter_type, typename ...Args>
@@ -2344,7 +2501,7 @@ namespace rsx
 
 			auto rtt_lookup = [&m_rtts, &cmd, &scale_x, &scale_y, this](u32 address, u32 width, u32 height, u32 pitch, u8 bpp, bool allow_clipped) -> typename surface_store_type::surface_overlap_info
 			{
-				const auto list = m_rtts.get_merged_texture_memory_region(cmd, address, width, height, pitch, bpp);
+				const auto& list = m_rtts.get_merged_texture_memory_region(cmd, address, width, height, pitch, bpp);
 				if (list.empty())
 				{
 					return {};
@@ -2924,6 +3081,7 @@ namespace rsx
 				if (m_cache_update_tag.load(std::memory_order_consume) != m_flush_always_update_timestamp)
 				{
 					std::lock_guard lock(m_cache_mutex);
+					protection_batch_scope protection_batch;
 					bool update_tag = false;
 
 					for (const auto &It : m_flush_always_cache)
@@ -2981,6 +3139,11 @@ namespace rsx
 			m_misses_this_frame.store(0u);
 			m_speculations_this_frame.store(0u);
 			m_unavoidable_hard_faults_this_frame.store(0u);
+			m_hash_verification_misses_this_frame.store(0u);
+			m_staged_readbacks_this_frame.store(0u);
+			memory_protection_batch::reset_statistics();
+			m_section_list_pool.reset_allocation_count();
+			m_sort_list_pool.reset_allocation_count();
 		}
 
 		void on_flush()
@@ -3043,6 +3206,24 @@ namespace rsx
 			return m_unavoidable_hard_faults_this_frame;
 		}
 
+		u32 get_num_hash_verification_misses() const
+		{
+			return m_hash_verification_misses_this_frame;
+		}
+
+		u32 get_num_staged_readbacks() const
+		{
+			return m_staged_readbacks_this_frame;
+		}
+
+		// Heap allocations made by the scratch pools this frame; stays at 0 once they have warmed up
+		// Only the pooled lists are counted. The slice lists built by gather_texture_slices() and merge_cache_resources()
+		// are handed to the backends inside the returned descriptor, so they are neither pooled nor counted.
+		u32 get_num_lookup_allocations() const
+		{
+			return m_section_list_pool.get_allocation_count() + m_sort_list_pool.get_allocation_count();
+		}
+
 		f32 get_cache_miss_ratio() const
 		{
 			const auto num_flushes = m_flushes_this_frame.load();
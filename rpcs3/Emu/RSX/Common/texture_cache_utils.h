@@ -3,11 +3,13 @@
 #include "../rsx_cache.h"
 #include "texture_cache_predictor.h"
 #include "TextureUtils.h"
+#include "../RSXOffload.h"
 
 #include <list>
 #include <unordered_set>
 #include <atomic>
 
+extern u64 get_system_time();
 
 namespace rsx
 {
@@ -125,6 +127,103 @@ namespace rsx
 	};
 
 
+	/**
+	 * Pool of reusable vectors for short-lived lookup results.
+	 * A lease hands its vector back to the pool when it goes out of scope; the capacity is kept,
+	 * so once the pool has warmed up, lookups run without touching the heap.
+	 * Every pool-side allocation (new vector or capacity growth) is counted.
+	 */
+	template <typename T>
+	class scratch_vector_pool
+	{
+		using vector_type = std::vector<T>;
+
+		std::vector<std::unique_ptr<vector_type>> m_free;
+		shared_mutex m_mutex;
+		std::atomic<u32> m_allocations = { 0 };
+
+		void release(std::unique_ptr<vector_type>&& data, size_t initial_capacity)
+		{
+			if (data->capacity() != initial_capacity)
+			{
+				m_allocations++;
+			}
+
+			data->clear();
+
+			std::lock_guard lock(m_mutex);
+			m_free.push_back(std::move(data));
+		}
+
+	public:
+		class lease
+		{
+			scratch_vector_pool* m_pool = nullptr;
+			std::unique_ptr<vector_type> m_data;
+			size_t m_initial_capacity = 0;
+
+		public:
+			lease(scratch_vector_pool* pool, std::unique_ptr<vector_type>&& data)
+				: m_pool(pool), m_data(std::move(data)), m_initial_capacity(m_data->capacity())
+			{}
+
+			lease(lease&& other) = default;
+			lease(const lease&) = delete;
+			lease& operator=(const lease&) = delete;
+
+			~lease()
+			{
+				if (m_data)
+				{
+					m_pool->release(std::move(m_data), m_initial_capacity);
+				}
+			}
+
+			vector_type& operator*() { return *m_data; }
+			const vector_type& operator*() const { return *m_data; }
+			vector_type* operator->() { return m_data.get(); }
+			const vector_type* operator->() const { return m_data.get(); }
+
+			operator const vector_type&() const { return *m_data; }
+
+			auto begin() const { return m_data->begin(); }
+			auto end() const { return m_data->end(); }
+			bool empty() const { return m_data->empty(); }
+			size_t size() const { return m_data->size(); }
+			const T& back() const { return m_data->back(); }
+			const T& operator[](size_t index) const { return (*m_data)[index]; }
+		};
+
+		lease acquire()
+		{
+			{
+				std::lock_guard lock(m_mutex);
+
+				if (!m_free.empty())
+				{
+					auto data = std::move(m_free.back());
+					m_free.pop_back();
+					return{ this, std::move(data) };
+				}
+			}
+
+			m_allocations++;
+			return{ this, std::make_unique<vector_type>() };
+		}
+
+		// Number of allocations performed since the last reset
+		u32 get_allocation_count() const
+		{
+			return m_allocations.load();
+		}
+
+		void reset_allocation_count()
+		{
+			m_allocations.store(0);
+		}
+	};
+
+
 
 	/**
 	 * List structure used in Ranged Storage Blocks
@@ -916,7 +1015,7 @@ namespace rsx
 				{
 					for (auto &tex : block)
 					{
-						if (tex.is_locked())
+						if (tex.is_locked() && !tex.is_hash_guarded())
 						{
 							tex_cache_checker.add(tex.get_locked_range(), tex.get_protection());
 						}
@@ -996,6 +1095,17 @@ namespace rsx
 		size_t m_predictor_key_hash = 0;
 		predictor_entry_type *m_predictor_entry = nullptr;
 
+		// Invalidation history of this address range, survives reuse of the section for the same range
+		u32 recent_invalidations = 0;
+		u64 last_invalidation_time = 0;
+
+		// Hash checks that found the contents unchanged since the section was hash-locked
+		u32 clean_hash_checks = 0;
+
+		// Host copy of a completed speculative readback, taken from the start of the readback buffer
+		std::vector<u8> staged_data;
+		u64 staged_timestamp = 0; // sync_timestamp of the transfer held in staged_data
+
 	public:
 		u64 cache_tag = 0;
 		u64 last_write_tag = 0;
@@ -1031,6 +1141,13 @@ namespace rsx
 			AUDIT(memory_range.valid());
 			AUDIT(!is_locked());
 
+			if (!matches(memory_range))
+			{
+				// Invalidation history only applies to the same range
+				recent_invalidations = 0;
+				last_invalidation_time = 0;
+			}
+
 			// Destroy if necessary
 			destroy();
 
@@ -1053,6 +1170,7 @@ namespace rsx
 			synchronized = false;
 			flushed = false;
 			speculatively_flushed = false;
+			staged_timestamp = 0ull;
 
 			cache_tag = 0ull;
 			last_write_tag = 0ull;
@@ -1216,6 +1334,32 @@ namespace rsx
 
 
 	private:
+		/**
+		 * Hash verification policy
+		 * Read-only sections that keep getting invalidated pay for a fault, an unprotect and a reupload every time.
+		 * Once a small section is invalidated often enough, its next lock is hash-verified instead of page protected.
+		 * If its contents then stay unchanged for enough checks, it goes back to page protection.
+		 */
+		static constexpr u32 hash_verification_max_size = 0x10000;
+		static constexpr u32 hash_verification_min_invalidations = 4;
+		static constexpr u64 hash_verification_window = 1000000; // Invalidations further apart than this (us) restart the count
+		static constexpr u32 hash_verification_stable_checks = 256;
+
+		void record_invalidation()
+		{
+			const u64 now = get_system_time();
+			recent_invalidations = (now - last_invalidation_time < hash_verification_window) ? recent_invalidations + 1 : 1;
+			last_invalidation_time = now;
+		}
+
+		bool use_hash_verification() const
+		{
+			return g_cfg.video.hash_verified_textures &&
+				context == texture_upload_context::shader_read &&
+				get_section_size() <= hash_verification_max_size &&
+				recent_invalidations >= hash_verification_min_invalidations;
+		}
+
 		/**
 		 * Protection
 		 */
@@ -1230,6 +1374,7 @@ namespace rsx
 				// Blit and framebuffers may be unprotected and clean
 				if (context == texture_upload_context::shader_read)
 				{
+					record_invalidation();
 					set_dirty(true);
 				}
 			}
@@ -1247,10 +1392,32 @@ namespace rsx
 		inline void protect(utils::protection prot)
 		{
 			utils::protection old_prot = get_protection();
+
+			if (old_prot == utils::protection::rw)
+			{
+				set_hash_verified(use_hash_verification());
+				clean_hash_checks = 0;
+			}
+
 			rsx::buffered_section::protect(prot);
 			post_protect(old_prot, prot);
 		}
 
+		// Counts a hash check that found the contents unchanged, returns true once they have been stable long enough to use page protection again
+		bool record_clean_hash_check()
+		{
+			AUDIT(is_hash_guarded());
+			return ++clean_hash_checks >= hash_verification_stable_checks;
+		}
+
+		// Puts a hash-guarded section back under page protection, returns false if its memory was written since it was locked
+		bool end_hash_verification()
+		{
+			recent_invalidations = 0;
+			clean_hash_checks = 0;
+			return protect_hash_locked_range();
+		}
+
 		inline void protect(utils::protection prot, const std::pair<u32, u32>& range_confirm)
 		{
 			utils::protection old_prot = get_protection();
@@ -1401,7 +1568,28 @@ namespace rsx
 			}
 		}
 
-		void imp_flush()
+		// Returns the offset and length in the readback buffer of the data for the given part of the section
+		std::pair<u32, u32> get_readback_range(u32 valid_offset, u32 valid_length) const
+		{
+			if (real_pitch == rsx_pitch)
+			{
+				return { valid_offset, valid_length };
+			}
+
+			// In case of pitch mismatch, match the offset point to the correct point
+			u32 mapped_offset = 0;
+			if (UNLIKELY(valid_offset))
+			{
+				const u32 offset_in_x = valid_offset % rsx_pitch;
+				const u32 offset_in_y = valid_offset / rsx_pitch;
+				mapped_offset = (offset_in_y * real_pitch) + offset_in_x;
+			}
+
+			const u32 available_vmem = (get_section_size() / rsx_pitch) * real_pitch + std::min<u32>(get_section_size() % rsx_pitch, real_pitch);
+			return { mapped_offset, std::min(available_vmem - mapped_offset, valid_length) };
+		}
+
+		void imp_flush(bool use_staged_data)
 		{
 			AUDIT(synchronized);
 
@@ -1414,32 +1602,22 @@ namespace rsx
 			const auto valid_offset = valid_range.start - get_section_base();
 			AUDIT(valid_length > 0);
 
-			// In case of pitch mismatch, match the offset point to the correct point
-			u32 mapped_offset, mapped_length;
-			if (real_pitch != rsx_pitch)
-			{
-				if (LIKELY(!valid_offset))
-				{
-					mapped_offset = 0;
-				}
-				else if (valid_offset)
-				{
-					const u32 offset_in_x = valid_offset % rsx_pitch;
-					const u32 offset_in_y = valid_offset / rsx_pitch;
-					mapped_offset = (offset_in_y * real_pitch) + offset_in_x;
-				}
+			const auto mapped = get_readback_range(valid_offset, valid_length);
+			const u32 mapped_offset = mapped.first;
+			const u32 mapped_length = mapped.second;
 
-				const u32 available_vmem = (get_section_size() / rsx_pitch) * real_pitch + std::min<u32>(get_section_size() % rsx_pitch, real_pitch);
-				mapped_length = std::min(available_vmem - mapped_offset, valid_length);
+			// Obtain pointers to the source and destination memory regions
+			u8 *src;
+			if (use_staged_data)
+			{
+				verify(HERE), (mapped_offset + mapped_length) <= staged_data.size();
+				src = staged_data.data() + mapped_offset;
 			}
 			else
 			{
-				mapped_offset = valid_offset;
-				mapped_length = valid_length;
+				src = static_cast<u8*>(derived()->map_synchronized(mapped_offset, mapped_length));
 			}
 
-			// Obtain pointers to the source and destination memory regions
-			u8 *src = static_cast<u8*>(derived()->map_synchronized(mapped_offset, mapped_length));
 			u32 dst = valid_range.start;
 			ASSERT(src != nullptr);
 
@@ -1491,17 +1669,66 @@ namespace rsx
 			// NOTE: Hard faults should have been pre-processed beforehand
 			ASSERT(synchronized);
 
-			// Copy flush result to guest memory
-			imp_flush();
+			// Copy flush result to guest memory, straight from the staged copy if the readback has already been staged
+			const bool use_staged_data = is_readback_staged();
+			imp_flush(use_staged_data);
+
+			if (use_staged_data)
+			{
+				staged_timestamp = 0;
+			}
+			else
+			{
+				derived()->unmap_synchronized();
+			}
 
 			// Finish up
 			// Its highly likely that this surface will be reused, so we just leave resources in place
 			flushed = true;
-			derived()->finish_flush();
+			derived()->finish_flush(use_staged_data);
 			flush_exclusions.clear();
 			on_flush();
 		}
 
+		/**
+		 * Readback staging
+		 * A speculative readback that has completed on the GPU is copied to host memory ahead of time,
+		 * so that the CPU access that eventually flushes the section only has to copy it into guest memory.
+		 */
+		// Staging consumes the readback like a flush does; once staged, the section can only be flushed from the staged copy
+		bool is_readback_staged() const
+		{
+			return staged_timestamp != 0 && staged_timestamp == sync_timestamp;
+		}
+
+		// Starts copying a completed readback to host memory on the offload workers; returns false if there is nothing to stage yet.
+		// The readback buffer stays mapped until finish_readback_staging is called, which must happen after the workers have completed.
+		bool begin_readback_staging()
+		{
+			if (!synchronized || flushed || is_readback_staged() || !exists() || !is_locked())
+				return false;
+
+			if (!derived()->supports_readback_staging() || !derived()->is_readback_complete())
+				return false;
+
+			// Cover the whole section so that any part of it can be flushed from the staged copy
+			const auto mapped = get_readback_range(0, get_section_size());
+			const u32 length = std::min(mapped.second, derived()->get_readback_buffer_size());
+
+			staged_data.resize(length);
+			g_dma_manager.copy(staged_data.data(), derived()->map_synchronized(0, length), length);
+			staged_timestamp = sync_timestamp;
+			return true;
+		}
+
+		void finish_readback_staging()
+		{
+			derived()->unmap_synchronized();
+
+			// Do the conversions the flush would otherwise do in guest memory
+			derived()->convert_staged_data(staged_data.data(), ::size32(staged_data));
+		}
+
 		void add_flush_exclusion(const address_range& rng)
 		{
 			AUDIT(exists() && is_locked() && is_flushable());
@@ -0,0 +1,504 @@
+#include "stdafx.h"
+#include "upload_benchmark.h"
+#include "TextureUtils.h"
+#include "BufferUtils.h"
+#include "ProgramStateCache.h"
+#include "shader_cache_archive.h"
+#include "../RSXThread.h"
+#include "../rsx_utils.h"
+#include "Utilities/Timer.h"
+
+#include <cstdio>
+
+namespace rsx
+{
+	namespace
+	{
+		// Minimum wall time spent on each case; keeps results stable without making the full run too long
+		constexpr u64 min_case_duration_us = 100'000;
+		constexpr u32 min_case_iterations = 3;
+
+		struct texture_format_desc
+		{
+			const char* name;
+			u32 format;
+		};
+
+		const texture_format_desc g_texture_formats[] =
+		{
+			{ "B8", CELL_GCM_TEXTURE_B8 },
+			{ "A1R5G5B5", CELL_GCM_TEXTURE_A1R5G5B5 },
+			{ "A4R4G4B4", CELL_GCM_TEXTURE_A4R4G4B4 },
+			{ "R5G6B5", CELL_GCM_TEXTURE_R5G6B5 },
+			{ "A8R8G8B8", CELL_GCM_TEXTURE_A8R8G8B8 },
+			{ "DXT1", CELL_GCM_TEXTURE_COMPRESSED_DXT1 },
+			{ "DXT23", CELL_GCM_TEXTURE_COMPRESSED_DXT23 },
+			{ "DXT45", CELL_GCM_TEXTURE_COMPRESSED_DXT45 },
+			{ "G8B8", CELL_GCM_TEXTURE_G8B8 },
+			{ "B8R8_G8R8", CELL_GCM_TEXTURE_COMPRESSED_B8R8_G8R8 },
+			{ "R8B8_R8G8", CELL_GCM_TEXTURE_COMPRESSED_R8B8_R8G8 },
+			{ "R6G5B5", CELL_GCM_TEXTURE_R6G5B5 },
+			{ "DEPTH24_D8", CELL_GCM_TEXTURE_DEPTH24_D8 },
+			{ "DEPTH24_D8_FLOAT", CELL_GCM_TEXTURE_DEPTH24_D8_FLOAT },
+			{ "DEPTH16", CELL_GCM_TEXTURE_DEPTH16 },
+			{ "DEPTH16_FLOAT", CELL_GCM_TEXTURE_DEPTH16_FLOAT },
+			{ "X16", CELL_GCM_TEXTURE_X16 },
+			{ "Y16_X16", CELL_GCM_TEXTURE_Y16_X16 },
+			{ "R5G5B5A1", CELL_GCM_TEXTURE_R5G5B5A1 },
+			{ "HILO8", CELL_GCM_TEXTURE_COMPRESSED_HILO8 },
+			{ "HILO_S8", CELL_GCM_TEXTURE_COMPRESSED_HILO_S8 },
+			{ "W16_Z16_Y16_X16_FLOAT", CELL_GCM_TEXTURE_W16_Z16_Y16_X16_FLOAT },
+			{ "W32_Z32_Y32_X32_FLOAT", CELL_GCM_TEXTURE_W32_Z32_Y32_X32_FLOAT },
+			{ "X32_FLOAT", CELL_GCM_TEXTURE_X32_FLOAT },
+			{ "D1R5G5B5", CELL_GCM_TEXTURE_D1R5G5B5 },
+			{ "D8R8G8B8", CELL_GCM_TEXTURE_D8R8G8B8 },
+			{ "Y16_X16_FLOAT", CELL_GCM_TEXTURE_Y16_X16_FLOAT },
+		};
+
+		struct benchmark_context
+		{
+			std::string filter;
+			u32 cases_run = 0;
+			u32 cases_failed = 0;
+
+			bool accepts(const std::string& name) const
+			{
+				return filter.empty() || name.find(filter) != std::string::npos;
+			}
+
+			// Runs func until enough time has elapsed, func returns the number of source bytes consumed per call
+			template <typename F>
+			void run(const std::string& name, F&& func)
+			{
+				if (!accepts(name))
+				{
+					return;
+				}
+
+				cases_run++;
+
+				try
+				{
+					u64 bytes = 0;
+					u32 iterations = 0;
+
+					Timer timer;
+					timer.Start();
+
+					do
+					{
+						bytes += func();
+						iterations++;
+					}
+					while (iterations < min_case_iterations || timer.GetElapsedTimeInMicroSec() < min_case_duration_us);
+
+					// Bytes per microsecond is MB/s
+					const u64 elapsed_us = std::max<u64>(timer.GetElapsedTimeInMicroSec(), 1);
+					std::printf("%-64s %12.1f MB/s\n", name.c_str(), double(bytes) / elapsed_us);
+				}
+				catch (const std::exception& e)
+				{
+					cases_failed++;
+					std::printf("%-64s FAILED (%s)\n", name.c_str(), e.what());
+				}
+
+				std::fflush(stdout);
+			}
+		};
+
+		// Cheap deterministic filler, the decoders do not care about the contents
+		void fill_pattern(std::vector<u8>& data, u32 seed)
+		{
+			for (auto& byte : data)
+			{
+				seed = seed * 1664525 + 1013904223;
+				byte = static_cast<u8>(seed >> 24);
+			}
+		}
+
+		void benchmark_texture(benchmark_context& ctx, const texture_format_desc& desc, u16 size, bool full_mip_chain, u8 layers, u16 depth, bool is_swizzled)
+		{
+			const u32 format = desc.format;
+			const u16 mipmaps = full_mip_chain ? static_cast<u16>(floor_log2(size) + 1) : 1;
+
+			const auto name = fmt::format("texture.%s.%s.%ux%ux%u%s.mip%u", desc.name, is_swizzled ? "swizzled" : "linear",
+				size, size, depth, layers > 1 ? ".cube" : "", mipmaps);
+
+			if (!ctx.accepts(name))
+			{
+				return;
+			}
+
+			const u32 block_edge = get_format_block_size_in_texel(format);
+			const u32 block_size = get_format_block_size_in_bytes(format);
+			const u32 width_in_block = (size + block_edge - 1) / block_edge;
+
+			// Source texture in RSX layout. Linear mips keep the base pitch and each level has at most (h / 2^n) + 1 rows,
+			// so this is an upper bound for the whole chain including the 128 byte layer alignment
+			const u32 src_pitch = width_in_block * block_size;
+			std::vector<u8> src(size_t{ src_pitch } * (width_in_block * 2 + mipmaps) * depth * layers + 128 * layers);
+			fill_pattern(src, format);
+
+			const auto layouts = get_subresources_layout(reinterpret_cast<const gsl::byte*>(src.data()), format | (is_swizzled ? 0 : CELL_GCM_TEXTURE_LN),
+				size, size, depth, layers, mipmaps, src_pitch, is_swizzled, false);
+
+			verify(HERE), (layouts.back().data.data() + layouts.back().data.size_bytes()) <= reinterpret_cast<const gsl::byte*>(src.data() + src.size());
+
+			// Staging buffer laid out the same way the Vulkan and D3D12 backends do it
+			std::vector<u8> dst(get_placed_texture_storage_size(size, size, depth, format, mipmaps, layers > 1, 256, 512) + 512 * layouts.size());
+			const bool vtc_support = false;
+
+			ctx.run(name, [&]()
+			{
+				u64 bytes = 0;
+				size_t offset_in_buffer = 0;
+
+				for (const auto& layout : layouts)
+				{
+					const size_t row_pitch = align(layout.width_in_block * block_size, 256);
+					const size_t image_linear_size = row_pitch * layout.height_in_block * layout.depth;
+
+					gsl::span<gsl::byte> mapped{ reinterpret_cast<gsl::byte*>(dst.data() + offset_in_buffer), ::narrow<int>(image_linear_size) };
+					upload_texture_subresource(mapped, layout, format, is_swizzled, vtc_support, 256);
+
+					offset_in_buffer = align(offset_in_buffer + image_linear_size, 512);
+					bytes += layout.data.size_bytes();
+				}
+
+				return bytes;
+			});
+		}
+
+		void benchmark_textures(benchmark_context& ctx)
+		{
+			for (const auto& desc : g_texture_formats)
+			{
+				for (const bool is_swizzled : { true, false })
+				{
+					for (const u16 size : { 64, 256, 1024, 2048 })
+					{
+						benchmark_texture(ctx, desc, size, false, 1, 1, is_swizzled);
+						benchmark_texture(ctx, desc, size, true, 1, 1, is_swizzled);
+					}
+
+					// Cubemap with a full mip chain
+					benchmark_texture(ctx, desc, 512, true, 6, 1, is_swizzled);
+
+					// Volume textures, this exercises the VTC detiling path for compressed formats
+					benchmark_texture(ctx, desc, 128, false, 1, 8, is_swizzled);
+				}
+			}
+		}
+
+		void benchmark_vertex_arrays(benchmark_context& ctx)
+		{
+			constexpr u32 vertex_count = 65536;
+			constexpr u32 interleaved_stride = 32;
+
+			const std::pair<const char*, vertex_base_type> types[] =
+			{
+				{ "s1", vertex_base_type::s1 },
+				{ "f", vertex_base_type::f },
+				{ "sf", vertex_base_type::sf },
+				{ "ub", vertex_base_type::ub },
+				{ "s32k", vertex_base_type::s32k },
+				{ "cmp", vertex_base_type::cmp },
+				{ "ub256", vertex_base_type::ub256 },
+			};
+
+			std::vector<u8> src(vertex_count * interleaved_stride + 16);
+			std::vector<u8> dst(vertex_count * 16 + 16);
+			fill_pattern(src, vertex_count);
+
+			for (const auto& type : types)
+			{
+				// CMP is always a single packed dword and UB256 is only valid as a 4-component vector
+				const u32 min_elements = type.second == vertex_base_type::ub256 ? 4 : 1;
+				const u32 max_elements = type.second == vertex_base_type::cmp ? 1 : 4;
+
+				for (u32 elements = min_elements; elements <= max_elements; ++elements)
+				{
+					const u32 element_size = get_vertex_type_size_on_host(type.second, elements);
+
+					// CMP is expanded to 4x16-bit on the host
+					const u8 dst_stride = type.second == vertex_base_type::cmp ? 8 : static_cast<u8>(element_size);
+
+					for (const u32 src_stride : { element_size, interleaved_stride })
+					{
+						for (const bool swap_endianness : { true, false })
+						{
+							const auto name = fmt::format("vertex.%s.x%u.%s.%s", type.first, elements,
+								src_stride == interleaved_stride ? "interleaved" : "packed", swap_endianness ? "swapped" : "native");
+
+							ctx.run(name, [&]()
+							{
+								gsl::span<const gsl::byte> src_span{ reinterpret_cast<const gsl::byte*>(src.data()), ::narrow<int>(vertex_count * src_stride) };
+								gsl::span<gsl::byte> dst_span{ reinterpret_cast<gsl::byte*>(dst.data()), ::narrow<int>(dst.size()) };
+								write_vertex_array_data_to_buffer(dst_span, src_span, vertex_count, type.second, elements, src_stride, dst_stride, swap_endianness);
+								return u64{ vertex_count } * element_size;
+							});
+						}
+					}
+				}
+			}
+		}
+
+		template <typename T>
+		void benchmark_index_type(benchmark_context& ctx, const char* type_name, index_array_type type)
+		{
+			constexpr u32 index_count = 3 * 65536;
+			constexpr u32 restart_interval = 64;
+
+			std::vector<u8> src(index_count * sizeof(T));
+			std::vector<u8> dst(get_index_count(primitive_type::triangle_fan, index_count) * sizeof(T) + 16);
+
+			// Small indices are more representative than random data and keep min/max tracking meaningful
+			const auto typed_src = reinterpret_cast<be_t<T>*>(src.data());
+			for (u32 i = 0; i < index_count; ++i)
+			{
+				typed_src[i] = static_cast<T>(i % 0x8000);
+			}
+
+			const auto expand_all = [](primitive_type) { return true; };
+			const auto expand_none = [](primitive_type) { return false; };
+
+			const std::pair<const char*, primitive_type> modes[] =
+			{
+				{ "triangles", primitive_type::triangles },
+				{ "triangle_fan", primitive_type::triangle_fan },
+				{ "quads", primitive_type::quads },
+			};
+
+			for (const bool restart : { false, true })
+			{
+				if (restart)
+				{
+					for (u32 i = restart_interval - 1; i < index_count; i += restart_interval)
+					{
+						typed_src[i] = static_cast<T>(-1);
+					}
+				}
+
+				for (const auto& mode : modes)
+				{
+					const auto name = fmt::format("index.%s.%s%s", type_name, mode.first, restart ? ".restart" : "");
+
+					ctx.run(name, [&]()
+					{
+						gsl::span<const gsl::byte> src_span{ reinterpret_cast<const gsl::byte*>(src.data()), ::narrow<int>(src.size()) };
+						gsl::span<gsl::byte> dst_span{ reinterpret_cast<gsl::byte*>(dst.data()), ::narrow<int>(get_index_count(mode.second, index_count) * sizeof(T)) };
+
+						write_index_array_data_to_buffer(dst_span, src_span, type, mode.second, restart, static_cast<T>(-1),
+							is_primitive_native(mode.second) ? std::function<bool(primitive_type)>(expand_none) : std::function<bool(primitive_type)>(expand_all));
+
+						return u64{ src.size() };
+					});
+				}
+			}
+		}
+
+		void benchmark_index_arrays(benchmark_context& ctx)
+		{
+			benchmark_index_type<u16>(ctx, "u16", index_array_type::u16);
+			benchmark_index_type<u32>(ctx, "u32", index_array_type::u32);
+
+			// Index generation for non-indexed draws of primitives the host cannot render natively
+			constexpr u32 vertex_count = 0x8000;
+			std::vector<u8> dst(get_index_count(primitive_type::triangle_fan, vertex_count) * sizeof(u16) + 16);
+
+			const std::pair<const char*, primitive_type> modes[] =
+			{
+				{ "line_loop", primitive_type::line_loop },
+				{ "triangle_fan", primitive_type::triangle_fan },
+				{ "quads", primitive_type::quads },
+			};
+
+			for (const auto& mode : modes)
+			{
+				ctx.run(fmt::format("index.generated.%s", mode.first), [&]()
+				{
+					write_index_array_for_non_indexed_non_native_primitive_to_buffer(reinterpret_cast<char*>(dst.data()), mode.second, vertex_count);
+					return u64{ get_index_count(mode.second, vertex_count) * sizeof(u16) };
+				});
+			}
+		}
+
+		// Keeps the hash results alive so the loops are not optimized out
+		volatile u64 g_hash_sink = 0;
+
+		void benchmark_programs(benchmark_context& ctx, const std::string& shader_cache_path)
+		{
+			if (!fs::is_file(shader_cache_path))
+			{
+				std::printf("Shader cache archive %s not found, program cases skipped\n", shader_cache_path.c_str());
+				return;
+			}
+
+			shader_cache_archive archive;
+			if (!archive.open(shader_cache_path))
+			{
+				std::printf("Shader cache archive %s could not be opened, program cases skipped\n", shader_cache_path.c_str());
+				return;
+			}
+
+			// Programs are compared against copies of themselves, which is the full walk done on every cache hit
+			std::vector<RSXVertexProgram> vertex_programs;
+			std::vector<RSXFragmentProgram> fragment_programs;
+			std::vector<std::vector<u8>> fragment_copies;
+			u64 vertex_bytes = 0;
+			u64 fragment_bytes = 0;
+
+			archive.for_each(shader_cache_archive::vertex_program, [&](u64, const u8* data, u32 size)
+			{
+				RSXVertexProgram vp = {};
+				vp.data.resize(size / sizeof(u32));
+				std::memcpy(vp.data.data(), data, vp.data.size() * sizeof(u32));
+				vp.skip_vertex_input_check = true;
+
+				// The instruction masks are stored with the pipelines, not the ucode; treat every instruction as reachable
+				const u32 count = std::min<u32>(::size32(vp.data) / 4, 512);
+				for (u32 i = 0; i < count; ++i)
+				{
+					vp.instruction_mask[i] = true;
+				}
+
+				vertex_bytes += size;
+				vertex_programs.push_back(std::move(vp));
+			});
+
+			archive.for_each(shader_cache_archive::fragment_program, [&](u64, const u8* data, u32 size)
+			{
+				if (size < 16)
+				{
+					return;
+				}
+
+				fragment_copies.emplace_back(data, data + size);
+
+				RSXFragmentProgram fp;
+				fp.addr = const_cast<u8*>(data);
+				fp.ucode_length = size;
+				fragment_bytes += size;
+				fragment_programs.push_back(fp);
+			});
+
+			std::printf("%u vertex and %u fragment programs loaded from %s\n", ::size32(vertex_programs), ::size32(fragment_programs), shader_cache_path.c_str());
+
+			if (!vertex_programs.empty())
+			{
+				const std::vector<RSXVertexProgram> vertex_copies = vertex_programs;
+
+				ctx.run("program.vertex.hash.fnv", [&]()
+				{
+					u64 hash = 0;
+					for (const auto& vp : vertex_programs)
+					{
+						hash ^= program_hash_util::vertex_program_utils::get_vertex_program_ucode_hash(vp);
+					}
+
+					g_hash_sink = hash;
+					return vertex_bytes;
+				});
+
+				ctx.run("program.vertex.hash.crc32c", [&]()
+				{
+					u64 hash = 0;
+					for (const auto& vp : vertex_programs)
+					{
+						hash ^= program_hash_util::vertex_program_utils::get_vertex_program_ucode_crc(vp);
+					}
+
+					g_hash_sink = hash;
+					return vertex_bytes;
+				});
+
+				ctx.run("program.vertex.compare.scalar", [&]()
+				{
+					for (size_t i = 0; i < vertex_programs.size(); ++i)
+					{
+						verify(HERE), program_hash_util::vertex_program_compare::compare_scalar(vertex_programs[i], vertex_copies[i]);
+					}
+					return vertex_bytes;
+				});
+
+				ctx.run("program.vertex.compare.simd", [&]()
+				{
+					for (size_t i = 0; i < vertex_programs.size(); ++i)
+					{
+						verify(HERE), program_hash_util::vertex_program_compare()(vertex_programs[i], vertex_copies[i]);
+					}
+					return vertex_bytes;
+				});
+			}
+
+			if (!fragment_programs.empty())
+			{
+				std::vector<RSXFragmentProgram> fragment_program_copies = fragment_programs;
+				for (size_t i = 0; i < fragment_programs.size(); ++i)
+				{
+					fragment_program_copies[i].addr = fragment_copies[i].data();
+				}
+
+				ctx.run("program.fragment.hash.fnv", [&]()
+				{
+					u64 hash = 0;
+					for (const auto& fp : fragment_programs)
+					{
+						hash ^= program_hash_util::fragment_program_utils::get_fragment_program_ucode_hash(fp);
+					}
+
+					g_hash_sink = hash;
+					return fragment_bytes;
+				});
+
+				ctx.run("program.fragment.hash.crc32c", [&]()
+				{
+					u64 hash = 0;
+					for (const auto& fp : fragment_programs)
+					{
+						hash ^= program_hash_util::fragment_program_utils::get_fragment_program_ucode_crc(fp);
+					}
+
+					g_hash_sink = hash;
+					return fragment_bytes;
+				});
+
+				ctx.run("program.fragment.compare.scalar", [&]()
+				{
+					for (size_t i = 0; i < fragment_programs.size(); ++i)
+					{
+						verify(HERE), program_hash_util::fragment_program_compare::compare_scalar(fragment_programs[i], fragment_program_copies[i]);
+					}
+					return fragment_bytes;
+				});
+
+				ctx.run("program.fragment.compare.simd", [&]()
+				{
+					for (size_t i = 0; i < fragment_programs.size(); ++i)
+					{
+						verify(HERE), program_hash_util::fragment_program_compare()(fragment_programs[i], fragment_program_copies[i]);
+					}
+					return fragment_bytes;
+				});
+			}
+		}
+	}
+
+	u32 run_upload_benchmark(const std::string& filter, const std::string& shader_cache_path)
+	{
+		benchmark_context ctx;
+		ctx.filter = filter;
+
+		benchmark_textures(ctx);
+		benchmark_vertex_arrays(ctx);
+		benchmark_index_arrays(ctx);
+
+		if (!shader_cache_path.empty())
+		{
+			benchmark_programs(ctx, shader_cache_path);
+		}
+
+		std::printf("%u case(s) run, %u failed\n", ctx.cases_run, ctx.cases_failed);
+		return ctx.cases_failed;
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Utilities/types.h"
+
+#include <string>
+
+namespace rsx
+{
+	/**
+	 * Runs the CPU side of the texture, vertex and index upload paths on synthetic data.
+	 * Every CELL_GCM_TEXTURE_* format is decoded in swizzled and linear layouts across several sizes and mip counts,
+	 * followed by all vertex base types and index expansion modes. Results are printed to stdout in MB/s.
+	 * If a shader cache archive (.pak) is given, the programs it holds are also hashed and compared, in MB of ucode/s.
+	 * Only cases whose name contains filter are run; an empty filter runs everything.
+	 * Returns the number of cases that failed (threw) during the run.
+	 */
+	u32 run_upload_benchmark(const std::string& filter, const std::string& shader_cache_path = "");
+}
@@ -9,6 +9,7 @@
 #include "../Common/BufferUtils.h"
 #include "D3D12Formats.h"
 #include "../rsx_methods.h"
+#include "../RSXOffload.h"
 
 namespace
 {
@@ -158,8 +159,9 @@ namespace
 				m_buffer_data.map<void>(CD3DX12_RANGE(heap_offset, heap_offset + buffer_size));
 			gsl::span<gsl::byte> mapped_buffer_span = {
 				(gsl::byte*)mapped_buffer, gsl::narrow_cast<int>(buffer_size)};
-			write_vertex_array_data_to_buffer(mapped_buffer_span, vertex_array.data, vertex_count,
+			rsx::g_dma_manager.convert_vertex_array(mapped_buffer_span, vertex_array.data, vertex_count,
 				vertex_array.type, vertex_array.attribute_size, vertex_array.stride, element_size, vertex_array.is_be);
+			rsx::g_dma_manager.sync();
 
 			m_buffer_data.unmap(CD3DX12_RANGE(heap_offset, heap_offset + buffer_size));
 
@@ -148,6 +148,29 @@ struct D3D12Traits
 		vertexProgramData.id = (u32)ID;
 	}
 
+	// Decompiled programs are not cached on disk for D3D12; the vertex program also depends on the vertex inputs
+	static
+	bool load_fragment_program(const rsx::shader_cache_archive&, u64, const RSXFragmentProgram&, fragment_program_type&, size_t)
+	{
+		return false;
+	}
+
+	static
+	bool load_vertex_program(const rsx::shader_cache_archive&, u64, const RSXVertexProgram&, vertex_program_type&, size_t)
+	{
+		return false;
+	}
+
+	static
+	void store_fragment_program(rsx::shader_cache_archive&, u64, const fragment_program_type&)
+	{
+	}
+
+	static
+	void store_vertex_program(rsx::shader_cache_archive&, u64, const vertex_program_type&)
+	{
+	}
+
 	static
 	void validate_pipeline_properties(const vertex_program_type&, const fragment_program_type&, pipeline_properties&)
 	{
@@ -7,6 +7,7 @@
 #include "GLCommonDecompiler.h"
 #include "../GCM.h"
 #include "../Common/GLSLCommon.h"
+#include "Utilities/hash.h"
 
 std::string GLFragmentDecompilerThread::getFloatTypeName(size_t elementCount)
 {
@@ -389,16 +390,22 @@ GLFragmentProgram::~GLFragmentProgram()
 	Delete();
 }
 
+static bool use_native_half_types()
+{
+	if (g_cfg.video.disable_native_float16)
+	{
+		return false;
+	}
+
+	const auto driver_caps = gl::get_driver_caps();
+	return driver_caps.NV_gpu_shader5_supported || driver_caps.AMD_gpu_shader_half_float_supported;
+}
+
 void GLFragmentProgram::Decompile(const RSXFragmentProgram& prog)
 {
 	u32 size;
 	GLFragmentDecompilerThread decompiler(shader, parr, prog, size);
-
-	if (!g_cfg.video.disable_native_float16)
-	{
-		const auto driver_caps = gl::get_driver_caps();
-		decompiler.device_props.has_native_half_support = driver_caps.NV_gpu_shader5_supported || driver_caps.AMD_gpu_shader_half_float_supported;
-	}
+	decompiler.device_props.has_native_half_support = use_native_half_types();
 
 	decompiler.Task();
 
@@ -458,6 +465,58 @@ void GLFragmentProgram::Compile()
 	}
 }
 
+// Folds the driver and configuration properties that affect the generated source into key
+static u64 get_archive_key(u64 key)
+{
+	const auto& driver_caps = gl::get_driver_caps();
+
+	// The half type extension required by the source, see insertHeader (0 = none, 1 = NV_gpu_shader5, 2 = AMD_gpu_shader_half_float)
+	const u64 half_extension = !use_native_half_types() ? 0 : driver_caps.NV_gpu_shader5_supported ? 1 : 2;
+
+	const std::array<u64, 2> data =
+	{
+		key,
+		half_extension | u64{ g_cfg.video.antialiasing_level == msaa_level::none } << 2 | u64{ driver_caps.vendor_NVIDIA } << 3
+	};
+
+	return rpcs3::hash_struct(data);
+}
+
+bool GLFragmentProgram::Load(const rsx::shader_cache_archive& archive, u64 key)
+{
+	key = get_archive_key(key);
+
+	std::vector<u8> data;
+	if (!archive.read(rsx::shader_cache_archive::decompiled_fragment_program, key, data))
+	{
+		return false;
+	}
+
+	rsx::shader_cache_archive::object_reader reader(data);
+	reader.read(shader);
+	reader.read(FragmentConstantOffsetCache);
+
+	if (!reader.valid())
+	{
+		LOG_ERROR(RSX, "Decompiled fragment program 0x%llx is corrupt", key);
+		shader.clear();
+		FragmentConstantOffsetCache.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void GLFragmentProgram::Store(rsx::shader_cache_archive& archive, u64 key) const
+{
+	key = get_archive_key(key);
+
+	rsx::shader_cache_archive::object_writer writer;
+	writer.write(shader);
+	writer.write(FragmentConstantOffsetCache);
+	archive.append(rsx::shader_cache_archive::decompiled_fragment_program, key, writer.data().data(), ::size32(writer.data()));
+}
+
 void GLFragmentProgram::Delete()
 {
 	shader.clear();
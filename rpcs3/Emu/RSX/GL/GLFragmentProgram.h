@@ -1,6 +1,7 @@
 #pragma once
 #include "../Common/FragmentProgramDecompiler.h"
 #include "Emu/RSX/RSXFragmentProgram.h"
+#include "../Common/shader_cache_archive.h"
 
 struct GLFragmentDecompilerThread : public FragmentProgramDecompiler
 {
@@ -55,6 +56,12 @@ public:
 	/** Compile the decompiled fragment shader into a format we can use with OpenGL. */
 	void Compile();
 
+	/** Restore the decompiled shader stored under key by a previous run. Returns false if there is none. */
+	bool Load(const rsx::shader_cache_archive& archive, u64 key);
+
+	/** Store the decompiled shader under key so that later runs can skip decompilation. */
+	void Store(rsx::shader_cache_archive& archive, u64 key) const;
+
 private:
 	/** Deletes the shader and any stored information */
 	void Delete();
@@ -33,8 +33,10 @@ GLGSRender::GLGSRender() : GSRender()
 
 	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
 		m_vertex_cache = std::make_unique<gl::null_vertex_cache>();
+	else if (g_cfg.video.gl_legacy_buffers)
+		m_vertex_cache = std::make_unique<gl::weak_vertex_cache>(); // Legacy buffers are orphaned when they wrap around
 	else
-		m_vertex_cache = std::make_unique<gl::weak_vertex_cache>();
+		m_vertex_cache = std::make_unique<gl::persistent_vertex_cache>();
 
 	supports_multidraw = true;
 	supports_native_ui = (bool)g_cfg.misc.use_native_interface;
@@ -233,6 +235,7 @@ void GLGSRender::end()
 	// Load textures
 	{
 		m_profiler.start();
+		rsx::frame_stage_scope texture_scope(m_frame_timings, rsx::frame_stage::texture_cache);
 
 		std::lock_guard lock(m_sampler_mutex);
 		bool  update_framebuffer_sourced = false;
@@ -248,7 +251,7 @@ void GLGSRender::end()
 			if (!fs_sampler_state[i])
 				fs_sampler_state[i] = std::make_unique<gl::texture_cache::sampled_image_descriptor>();
 
-			if (m_samplers_dirty || m_textures_dirty[i] ||
+			if (m_samplers_dirty || m_textures_dirty[i] || fs_sampler_state[i]->is_hash_verified ||
 				(update_framebuffer_sourced && fs_sampler_state[i]->upload_context == rsx::texture_upload_context::framebuffer_storage))
 			{
 				auto sampler_state = static_cast<gl::texture_cache::sampled_image_descriptor*>(fs_sampler_state[i].get());
@@ -274,7 +277,7 @@ void GLGSRender::end()
 			if (!vs_sampler_state[i])
 				vs_sampler_state[i] = std::make_unique<gl::texture_cache::sampled_image_descriptor>();
 
-			if (m_samplers_dirty || m_vertex_textures_dirty[i] ||
+			if (m_samplers_dirty || m_vertex_textures_dirty[i] || vs_sampler_state[i]->is_hash_verified ||
 				(update_framebuffer_sourced && vs_sampler_state[i]->upload_context == rsx::texture_upload_context::framebuffer_storage))
 			{
 				auto sampler_state = static_cast<gl::texture_cache::sampled_image_descriptor*>(vs_sampler_state[i].get());
@@ -1272,6 +1275,8 @@ bool GLGSRender::do_method(u32 cmd, u32 arg)
 
 bool GLGSRender::load_program()
 {
+	rsx::frame_stage_scope lookup_scope(m_frame_timings, rsx::frame_stage::program_lookup);
+
 	if (m_graphics_state & rsx::pipeline_state::invalidate_pipeline_bits)
 	{
 		get_current_fragment_program(fs_sampler_state);
@@ -1652,7 +1657,7 @@ void GLGSRender::flip(int buffer, bool emu_flip)
 			else
 			{
 				gl::command_context cmd = { gl_state };
-				const auto overlap_info = m_rtts.get_merged_texture_memory_region(cmd, absolute_address, buffer_width, buffer_height, buffer_pitch, render_target_texture->get_bpp());
+				const auto& overlap_info = m_rtts.get_merged_texture_memory_region(cmd, absolute_address, buffer_width, buffer_height, buffer_pitch, render_target_texture->get_bpp());
 
 				if (!overlap_info.empty() && overlap_info.back().surface == render_target_texture)
 				{
@@ -1781,9 +1786,20 @@ void GLGSRender::flip(int buffer, bool emu_flip)
 		const auto num_misses = m_gl_texture_cache.get_num_cache_misses();
 		const auto num_unavoidable = m_gl_texture_cache.get_num_unavoidable_hard_faults();
 		const auto cache_miss_ratio = (u32)ceil(m_gl_texture_cache.get_cache_miss_ratio() * 100);
+		const auto num_lookup_allocations = m_gl_texture_cache.get_num_lookup_allocations();
+		const auto num_hash_misses = m_gl_texture_cache.get_num_hash_verification_misses();
+		const auto num_protect_requests = rsx::memory_protection_batch::get_num_requested();
+		const auto num_protect_calls = rsx::memory_protection_batch::get_num_issued();
+		const auto num_staged_readbacks = m_gl_texture_cache.get_num_staged_readbacks();
+		const auto program_lookups = m_prog_buffer.get_lookup_cache_statistics();
 		m_text_printer.print_text(0, 126, m_frame->client_width(), m_frame->client_height(), fmt::format("Unreleased textures: %7d", num_dirty_textures));
 		m_text_printer.print_text(0, 144, m_frame->client_width(), m_frame->client_height(), fmt::format("Texture memory: %12dM", texture_memory_size));
 		m_text_printer.print_text(0, 162, m_frame->client_width(), m_frame->client_height(), fmt::format("Flush requests: %12d  = %2d (%3d%%) hard faults, %2d unavoidable, %2d misprediction(s), %2d speculation(s)", num_flushes, num_misses, cache_miss_ratio, num_unavoidable, num_mispredict, num_speculate));
+		m_text_printer.print_text(0, 180, m_frame->client_width(), m_frame->client_height(), fmt::format("Lookup allocations: %8d", num_lookup_allocations));
+		m_text_printer.print_text(0, 198, m_frame->client_width(), m_frame->client_height(), fmt::format("Hash verification misses: %2d", num_hash_misses));
+		m_text_printer.print_text(0, 216, m_frame->client_width(), m_frame->client_height(), fmt::format("Page protection calls: %5d (%d requested)", num_protect_calls, num_protect_requests));
+		m_text_printer.print_text(0, 234, m_frame->client_width(), m_frame->client_height(), fmt::format("Staged readbacks: %10d", num_staged_readbacks));
+		m_text_printer.print_text(0, 252, m_frame->client_width(), m_frame->client_height(), fmt::format("Program lookups: %11d  = %d cached", program_lookups.first + program_lookups.second, program_lookups.first));
 	}
 
 	m_frame->flip(m_context);
@@ -1791,7 +1807,7 @@ void GLGSRender::flip(int buffer, bool emu_flip)
 
 	// Cleanup
 	m_gl_texture_cache.on_frame_end();
-	m_vertex_cache->purge();
+	m_vertex_cache->on_frame_end();
 
 	auto removed_textures = m_rtts.free_invalidated();
 	m_framebuffer_cache.remove_if([&](auto& fbo)
@@ -1817,6 +1833,7 @@ void GLGSRender::flip(int buffer, bool emu_flip)
 	m_draw_time = 0;
 	m_vertex_upload_time = 0;
 	m_textures_upload_time = 0;
+	m_prog_buffer.reset_lookup_cache_statistics();
 }
 
 bool GLGSRender::on_access_violation(u32 address, bool is_writing)
@@ -1869,6 +1886,7 @@ void GLGSRender::do_local_task(rsx::FIFO_state state)
 {
 	if (!work_queue.empty())
 	{
+		rsx::frame_stage_scope flush_scope(m_frame_timings, rsx::frame_stage::flush_wait);
 		std::lock_guard lock(queue_guard);
 
 		work_queue.remove_if([](work_item &q) { return q.received; });
@@ -1891,6 +1909,9 @@ void GLGSRender::do_local_task(rsx::FIFO_state state)
 			m_gl_texture_cache.do_update();
 			m_graphics_state &= ~rsx::pipeline_state::framebuffer_reads_dirty;
 		}
+
+		// Move completed speculative readbacks to host memory before the CPU asks for them
+		m_gl_texture_cache.stage_completed_readbacks();
 	}
 
 	rsx::thread::do_local_task(state);
@@ -980,6 +980,11 @@ namespace gl
 
 		virtual void reserve_storage_on_heap(u32 /*alloc_size*/) {}
 
+		u32 get_current_put_pos() const
+		{
+			return m_data_loc;
+		}
+
 		virtual void unmap() {}
 
 		void bind_range(u32 index, u32 offset, u32 size) const
@@ -26,6 +26,42 @@ struct GLTraits
 		vertexProgramData.Compile();
 	}
 
+	static
+	bool load_fragment_program(const rsx::shader_cache_archive& archive, u64 key, const RSXFragmentProgram& /*RSXFP*/, fragment_program_type& fragmentProgramData, size_t /*ID*/)
+	{
+		if (!fragmentProgramData.Load(archive, key))
+		{
+			return false;
+		}
+
+		fragmentProgramData.Compile();
+		return true;
+	}
+
+	static
+	bool load_vertex_program(const rsx::shader_cache_archive& archive, u64 key, const RSXVertexProgram& /*RSXVP*/, vertex_program_type& vertexProgramData, size_t /*ID*/)
+	{
+		if (!vertexProgramData.Load(archive, key))
+		{
+			return false;
+		}
+
+		vertexProgramData.Compile();
+		return true;
+	}
+
+	static
+	void store_fragment_program(rsx::shader_cache_archive& archive, u64 key, const fragment_program_type& fragmentProgramData)
+	{
+		fragmentProgramData.Store(archive, key);
+	}
+
+	static
+	void store_vertex_program(rsx::shader_cache_archive& archive, u64 key, const vertex_program_type& vertexProgramData)
+	{
+		vertexProgramData.Store(archive, key);
+	}
+
 	static
 	void validate_pipeline_properties(const vertex_program_type&, const fragment_program_type&, pipeline_properties&)
 	{
@@ -464,14 +464,47 @@ namespace gl
 			height = align(height, 4);
 		}
 
+		// Decode all subresources up front so that the worker threads can run ahead of the GL calls below
+		const u32 block_size = get_format_block_size_in_bytes(format);
+		std::vector<size_t> offsets(input_layouts.size());
+		std::vector<rsx::dma_manager::fence> fences(input_layouts.size());
+		size_t staging_size = 0;
+
+		for (const rsx_subresource_layout &layout : input_layouts)
+		{
+			offsets[&layout - input_layouts.data()] = staging_size;
+			staging_size += align<size_t>(align<size_t>(layout.width_in_block * block_size, 4) * layout.height_in_block * layout.depth, 16);
+		}
+
+		if (staging_buffer.size() < staging_size)
+		{
+			staging_buffer.resize(staging_size);
+		}
+
+		for (const rsx_subresource_layout &layout : input_layouts)
+		{
+			const size_t index = &layout - input_layouts.data();
+			const size_t end = (index + 1 < input_layouts.size()) ? offsets[index + 1] : staging_size;
+			gsl::span<gsl::byte> dst{ staging_buffer.data() + offsets[index], static_cast<gsl::span<gsl::byte>::index_type>(end - offsets[index]) };
+
+			rsx::g_dma_manager.upload_texture(dst, layout, format, is_swizzled, vtc_support, 4);
+			fences[index] = rsx::g_dma_manager.get_fence();
+		}
+
+		auto get_decoded_data = [&](const rsx_subresource_layout &layout)
+		{
+			const size_t index = &layout - input_layouts.data();
+			rsx::g_dma_manager.wait(fences[index]);
+			return staging_buffer.data() + offsets[index];
+		};
+
 		if (dim == rsx::texture_dimension_extended::texture_dimension_1d)
 		{
 			if (!is_compressed_format(format))
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glTexSubImage1D(GL_TEXTURE_1D, mip_level++, 0, layout.width_in_block, gl_format, gl_type, staging_buffer.data());
+					glTexSubImage1D(GL_TEXTURE_1D, mip_level++, 0, layout.width_in_block, gl_format, gl_type, get_decoded_data(layout));
 				}
 			}
 			else
@@ -479,8 +512,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glCompressedTexSubImage1D(GL_TEXTURE_1D, mip_level++, 0, layout.width_in_block * 4, gl_format, size, staging_buffer.data());
+					glCompressedTexSubImage1D(GL_TEXTURE_1D, mip_level++, 0, layout.width_in_block * 4, gl_format, size, get_decoded_data(layout));
 				}
 			}
 			return;
@@ -492,8 +524,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glTexSubImage2D(GL_TEXTURE_2D, mip_level++, 0, 0, layout.width_in_block, layout.height_in_block, gl_format, gl_type, staging_buffer.data());
+					glTexSubImage2D(GL_TEXTURE_2D, mip_level++, 0, 0, layout.width_in_block, layout.height_in_block, gl_format, gl_type, get_decoded_data(layout));
 				}
 			}
 			else
@@ -501,8 +532,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * layout.height_in_block * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glCompressedTexSubImage2D(GL_TEXTURE_2D, mip_level++, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, gl_format, size, staging_buffer.data());
+					glCompressedTexSubImage2D(GL_TEXTURE_2D, mip_level++, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, gl_format, size, get_decoded_data(layout));
 				}
 			}
 			return;
@@ -517,8 +547,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + mip_level / mipmap_count, mip_level % mipmap_count, 0, 0, layout.width_in_block, layout.height_in_block, gl_format, gl_type, staging_buffer.data());
+					glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + mip_level / mipmap_count, mip_level % mipmap_count, 0, 0, layout.width_in_block, layout.height_in_block, gl_format, gl_type, get_decoded_data(layout));
 					mip_level++;
 				}
 			}
@@ -527,8 +556,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * layout.height_in_block * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + mip_level / mipmap_count, mip_level % mipmap_count, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, gl_format, size, staging_buffer.data());
+					glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + mip_level / mipmap_count, mip_level % mipmap_count, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, gl_format, size, get_decoded_data(layout));
 					mip_level++;
 				}
 			}
@@ -541,8 +569,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glTexSubImage3D(GL_TEXTURE_3D, mip_level++, 0, 0, 0, layout.width_in_block, layout.height_in_block, depth, gl_format, gl_type, staging_buffer.data());
+					glTexSubImage3D(GL_TEXTURE_3D, mip_level++, 0, 0, 0, layout.width_in_block, layout.height_in_block, depth, gl_format, gl_type, get_decoded_data(layout));
 				}
 			}
 			else
@@ -550,8 +577,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * layout.height_in_block * layout.depth * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
-					glCompressedTexSubImage3D(GL_TEXTURE_3D, mip_level++, 0, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, layout.depth, gl_format, size, staging_buffer.data());
+					glCompressedTexSubImage3D(GL_TEXTURE_3D, mip_level++, 0, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, layout.depth, gl_format, size, get_decoded_data(layout));
 				}
 			}
 			return;
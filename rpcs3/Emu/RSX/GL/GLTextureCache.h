@@ -340,6 +340,12 @@ namespace gl
 		/**
 		 * Flush
 		 */
+		bool requires_manual_shuffle() const
+		{
+			// The pixel transfer does not swap bytes of byte types, these are shuffled on the CPU instead
+			return pack_unpack_swap_bytes && (type == gl::texture::type::sbyte || type == gl::texture::type::ubyte);
+		}
+
 		void* map_synchronized(u32 offset, u32 size)
 		{
 			AUDIT(synchronized && !m_fence.is_empty());
@@ -351,19 +357,41 @@ namespace gl
 			return glMapBufferRange(GL_PIXEL_PACK_BUFFER, offset, size, GL_MAP_READ_BIT);
 		}
 
-		void finish_flush()
+		void unmap_synchronized()
 		{
-			// Free resources
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_id);
 			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
 			glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+		}
+
+		bool is_readback_complete()
+		{
+			return !m_fence.is_empty() && m_fence.check_signaled();
+		}
+
+		bool supports_readback_staging() const
+		{
+			// The manual shuffle is done on the staged rows, they must map to guest rows one to one
+			return !requires_manual_shuffle() || real_pitch <= rsx_pitch;
+		}
 
-			// Shuffle
-			bool require_manual_shuffle = false;
-			if (pack_unpack_swap_bytes)
+		void convert_staged_data(u8* data, u32 length)
+		{
+			if (requires_manual_shuffle())
 			{
-				if (type == gl::texture::type::sbyte || type == gl::texture::type::ubyte)
-					require_manual_shuffle = true;
+				rsx::shuffle_texel_data_wzyx<u8>(data, real_pitch, width, length / real_pitch);
 			}
+		}
+
+		u32 get_readback_buffer_size() const
+		{
+			return pbo_size;
+		}
+
+		void finish_flush(bool from_staged_data)
+		{
+			// Shuffle, staged data has already been shuffled
+			const bool require_manual_shuffle = !from_staged_data && requires_manual_shuffle();
 
 			const auto valid_range = get_confirmed_range_delta();
 			const u32 valid_offset = valid_range.first;
@@ -153,6 +153,7 @@ namespace
 gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 {
 	m_profiler.start();
+	rsx::frame_stage_scope upload_scope(m_frame_timings, rsx::frame_stage::vertex_upload);
 
 	//Write index buffers and count verts
 	auto result = std::visit(draw_command_visitor(*m_index_ring_buffer, m_vertex_layout), get_draw_command(rsx::method_registers));
@@ -182,11 +183,13 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 		result.index_info                        // Index buffer info
 	};
 
+	// Keep the vertex cache informed of how far the heap has moved
+	m_vertex_cache->set_heap_position(m_attrib_ring_buffer->get_current_put_pos(), m_attrib_ring_buffer->size());
+
 	if (required.first > 0)
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
-		//TODO: make vertex cache keep local data beyond frame boundaries and hook notify command
 		bool in_cache = false;
 		bool to_store = false;
 		u32  storage_address = UINT32_MAX;
@@ -194,8 +197,10 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 		if (m_vertex_layout.interleaved_blocks.size() == 1 &&
 			rsx::method_registers.current_draw_clause.command != rsx::draw_command::inlined_array)
 		{
-			const auto data_offset = (vertex_base * m_vertex_layout.interleaved_blocks[0].attribute_stride);
-			storage_address = m_vertex_layout.interleaved_blocks[0].real_offset_address + data_offset;
+			// Key on the exact source range copied by write_vertex_data_to_memory
+			const auto& block = m_vertex_layout.interleaved_blocks[0];
+			const auto range = block.calculate_required_range(vertex_base, vertex_count);
+			storage_address = block.real_offset_address + (range.first * block.attribute_stride);
 
 			if (auto cached = m_vertex_cache->find_vertex_range(storage_address, GL_R8UI, required.first))
 			{
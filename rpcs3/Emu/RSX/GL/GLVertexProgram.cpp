@@ -6,6 +6,7 @@
 #include "GLCommonDecompiler.h"
 #include "GLHelpers.h"
 #include "../Common/GLSLCommon.h"
+#include "Utilities/hash.h"
 
 #include <algorithm>
 
@@ -377,6 +378,45 @@ void GLVertexProgram::Compile()
 	}
 }
 
+// Folds the driver properties that affect the generated source into key
+static u64 get_archive_key(u64 key)
+{
+	const std::array<u64, 2> data = { key, u64{ gl::get_driver_caps().vendor_INTEL } };
+	return rpcs3::hash_struct(data);
+}
+
+bool GLVertexProgram::Load(const rsx::shader_cache_archive& archive, u64 key)
+{
+	key = get_archive_key(key);
+
+	std::vector<u8> data;
+	if (!archive.read(rsx::shader_cache_archive::decompiled_vertex_program, key, data))
+	{
+		return false;
+	}
+
+	rsx::shader_cache_archive::object_reader reader(data);
+	reader.read(shader);
+
+	if (!reader.valid())
+	{
+		LOG_ERROR(RSX, "Decompiled vertex program 0x%llx is corrupt", key);
+		shader.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void GLVertexProgram::Store(rsx::shader_cache_archive& archive, u64 key) const
+{
+	key = get_archive_key(key);
+
+	rsx::shader_cache_archive::object_writer writer;
+	writer.write(shader);
+	archive.append(rsx::shader_cache_archive::decompiled_vertex_program, key, writer.data().data(), ::size32(writer.data()));
+}
+
 void GLVertexProgram::Delete()
 {
 	shader.clear();
@@ -1,6 +1,7 @@
 #pragma once
 #include "../Common/VertexProgramDecompiler.h"
 #include "Emu/RSX/RSXVertexProgram.h"
+#include "../Common/shader_cache_archive.h"
 
 enum
 {
@@ -54,6 +55,9 @@ public:
 	void Decompile(const RSXVertexProgram& prog);
 	void Compile();
 
+	bool Load(const rsx::shader_cache_archive& archive, u64 key);
+	void Store(rsx::shader_cache_archive& archive, u64 key) const;
+
 private:
 	void Delete();
 };
@@ -525,12 +525,14 @@ namespace rsx
 				{
 					// Emit end command to close existing scope
 					//verify(HERE), in_begin_end;
+					frame_stage_scope dispatch_scope(m_frame_timings, frame_stage::method_dispatch);
 					methods[NV4097_SET_BEGIN_END](this, NV4097_SET_BEGIN_END, 0);
 					break;
 				}
 				case FIFO::EMIT_BARRIER:
 				{
 					//verify(HERE), in_begin_end;
+					frame_stage_scope dispatch_scope(m_frame_timings, frame_stage::method_dispatch);
 					methods[NV4097_SET_BEGIN_END](this, NV4097_SET_BEGIN_END, 0);
 					methods[NV4097_SET_BEGIN_END](this, NV4097_SET_BEGIN_END, m_flattener.get_primitive());
 					break;
@@ -555,6 +557,7 @@ namespace rsx
 
 			if (auto method = methods[reg])
 			{
+				frame_stage_scope dispatch_scope(m_frame_timings, frame_stage::method_dispatch);
 				method(this, reg, value);
 			}
 		}
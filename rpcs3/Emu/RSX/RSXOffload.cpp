@@ -1,44 +1,78 @@
 ﻿#include "stdafx.h"
 
 #include "Common/BufferUtils.h"
+#include "Common/TextureUtils.h"
 #include "Emu/System.h"
 #include "RSXOffload.h"
+#include "RSXThread.h"
 
 #include <thread>
 #include <atomic>
+#include <chrono>
 
 namespace rsx
 {
+	namespace
+	{
+		// Set on the offload workers; work submitted from them is always executed inline to avoid waiting on ourselves
+		thread_local bool s_is_offload_worker = false;
+	}
+
 	// initialization
 	void dma_manager::init()
 	{
-		m_worker_state = thread_state::created;
-		m_enqueued_count.store(0);
-		m_processed_count = 0;
+		// Stop the workers of a previous session
+		join();
 
-		// Empty work queue in case of stale contents
-		m_work_queue.pop_all();
+		m_worker_count = 0;
+		m_next_worker = 0;
 
-		thread_ctrl::spawn("RSX offloader", [this]()
+		for (auto& worker : m_workers)
 		{
-			if (!g_cfg.video.multithreaded_rsx)
-			{
-				// Abort
-				return;
-			}
+			// Empty work queues in case of stale contents
+			worker.work_queue.pop_all();
+			worker.enqueued_count.store(0);
+			worker.processed_count.store(0);
+		}
 
-			if (g_cfg.core.thread_scheduler_enabled)
-			{
-				thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::rsx));
-			}
+		if (!g_cfg.video.multithreaded_rsx)
+		{
+			m_worker_state = thread_state::detached;
+			return;
+		}
+
+		// Keep the pool small, these threads compete with the PPU/SPU threads for cores
+		m_worker_count = std::clamp(std::thread::hardware_concurrency() / 4, 1u, max_workers);
+		m_worker_state = thread_state::created;
 
-			while (m_worker_state != thread_state::finished)
+		for (u32 index = 0; index < m_worker_count; ++index)
+		{
+			m_threads.emplace_back(fmt::format("RSX offloader %u", index), [this, index]()
 			{
-				if (m_enqueued_count.load() != m_processed_count)
+				if (g_cfg.core.thread_scheduler_enabled)
 				{
-					for (auto slice = m_work_queue.pop_all(); slice; slice.pop_front())
+					thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::rsx));
+				}
+
+				s_is_offload_worker = true;
+				auto& worker = m_workers[index];
+
+				while (m_worker_state != thread_state::finished)
+				{
+					if (worker.enqueued_count.load() == worker.processed_count.load())
 					{
-						auto task = *slice;
+						worker.work_queue.wait();
+					}
+
+					for (auto slice = worker.work_queue.pop_all(); slice; slice.pop_front())
+					{
+						auto& task = *slice;
+						if (task.type == wake)
+						{
+							// Not counted as work, see join()
+							continue;
+						}
+
 						switch (task.type)
 						{
 						case raw_copy:
@@ -53,84 +87,242 @@ namespace rsx
 								static_cast<rsx::primitive_type>(task.aux_param0),
 								task.length);
 							break;
+						case texture_decode:
+							upload_texture_subresource({ static_cast<gsl::byte*>(task.dst), ::narrow<int>(task.length) }, task.texture.layout,
+								task.texture.format, task.texture.is_swizzled, task.texture.vtc_support, task.texture.dst_row_pitch_multiple_of);
+							break;
+						case vertex_convert:
+							write_vertex_array_data_to_buffer({ static_cast<gsl::byte*>(task.dst), ::narrow<int>(task.vertex.dst_stride * task.length) },
+								{ static_cast<const gsl::byte*>(task.src), ::narrow<int>(task.vertex.src_length) }, task.length, task.vertex.type,
+								task.vertex.vector_element_count, task.vertex.attribute_src_stride, task.vertex.dst_stride, task.vertex.swap_endianness);
+							break;
 						default:
 							ASSUME(0);
 							fmt::throw_exception("Unreachable" HERE);
 						}
 
-						std::atomic_thread_fence(std::memory_order_release);
-						++m_processed_count;
+						worker.processed_count++;
 					}
 				}
-				else
-				{
-					// Yield
-					std::this_thread::yield();
-				}
-			}
+			});
+		}
+
+		calibrate();
+	}
+
+	void dma_manager::calibrate()
+	{
+		// Find the transfer size at which copying inline costs the submitting thread as much as handing the copy to a worker
+		constexpr u32 sample_size = 256 * 1024;
+		constexpr u32 sample_count = 64;
+
+		std::vector<u8> src(sample_size, 0xCD), dst(sample_size);
+		std::memcpy(dst.data(), src.data(), sample_size);
+
+		const auto copy_start = std::chrono::steady_clock::now();
+
+		for (u32 n = 0; n < sample_count; ++n)
+		{
+			std::memcpy(dst.data(), src.data(), sample_size);
+		}
+
+		const auto handoff_start = std::chrono::steady_clock::now();
+
+		for (u32 n = 0; n < sample_count; ++n)
+		{
+			enqueue({ dst.data(), src.data(), 0 });
+		}
+
+		sync();
+
+		const auto end = std::chrono::steady_clock::now();
+		const double copy_ns_per_byte = std::chrono::duration<double, std::nano>(handoff_start - copy_start).count() / (double(sample_size) * sample_count);
+		const double handoff_ns = std::chrono::duration<double, std::nano>(end - handoff_start).count() / sample_count;
 
-			m_processed_count = m_enqueued_count.load();
-		});
+		if (copy_ns_per_byte > 0.)
+		{
+			const u32 break_even = static_cast<u32>(std::min(handoff_ns / copy_ns_per_byte, 65536.));
+			m_max_immediate_transfer_size = std::clamp(align(break_even, 512u), 512u, 65536u);
+		}
+
+		LOG_NOTICE(RSX, "DMA: %u offload workers, immediate transfer threshold set to %u bytes (memcpy=%.3fns/KiB, handoff=%.1fns)",
+			m_worker_count, m_max_immediate_transfer_size, copy_ns_per_byte * 1024., handoff_ns);
+	}
+
+	bool dma_manager::can_offload(u32 length) const
+	{
+		return m_worker_count && length > m_max_immediate_transfer_size && !s_is_offload_worker;
+	}
+
+	void dma_manager::enqueue(transport_packet&& packet)
+	{
+		auto& worker = m_workers[m_next_worker++ % m_worker_count];
+
+		worker.enqueued_count++;
+		worker.work_queue.push(std::move(packet));
 	}
 
 	// General transport
 	void dma_manager::copy(void *dst, std::vector<u8>& src, u32 length)
 	{
-		if (length <= max_immediate_transfer_size || !g_cfg.video.multithreaded_rsx)
+		if (!can_offload(length))
 		{
 			std::memcpy(dst, src.data(), length);
 		}
 		else
 		{
-			++m_enqueued_count;
-			m_work_queue.push(dst, src, length);
+			enqueue({ dst, src, length });
 		}
 	}
 
 	void dma_manager::copy(void *dst, void *src, u32 length)
 	{
-		if (length <= max_immediate_transfer_size || !g_cfg.video.multithreaded_rsx)
+		if (!can_offload(length))
 		{
 			std::memcpy(dst, src, length);
 		}
 		else
 		{
-			++m_enqueued_count;
-			m_work_queue.push(dst, src, length);
+			enqueue({ dst, src, length });
+		}
+	}
+
+	// Texture utilities
+	void dma_manager::upload_texture(gsl::span<gsl::byte> dst, const rsx_subresource_layout& src, int format, bool is_swizzled, bool vtc_support, u32 dst_row_pitch_multiple_of)
+	{
+		if (!can_offload(::narrow<u32>(src.data.size_bytes())))
+		{
+			upload_texture_subresource(dst, src, format, is_swizzled, vtc_support, dst_row_pitch_multiple_of);
+			return;
+		}
+
+		// Swizzled, bordered and volume data cannot be cut along rows, hand the whole subresource to one worker
+		// The RB/RG decoders expand 16-bit source words into 32-bit texels, their row sizes do not follow the block size
+		if (is_swizzled || src.border || src.depth > 1 || src.width_in_block > src.pitch_in_block ||
+			format == CELL_GCM_TEXTURE_COMPRESSED_B8R8_G8R8 || format == CELL_GCM_TEXTURE_COMPRESSED_R8B8_R8G8)
+		{
+			enqueue({ dst, { src, format, is_swizzled, vtc_support, dst_row_pitch_multiple_of } });
+			return;
+		}
+
+		const u32 src_row_size = ::narrow<u32>(src.data.size_bytes() / src.height_in_block);
+		const u32 block_size = get_format_block_size_in_bytes(format);
+		const u32 dst_row_size = ::narrow<u32>(align<size_t>(src.width_in_block * block_size, dst_row_pitch_multiple_of) / block_size * block_size);
+		const u32 rows_per_band = std::max(band_size / src_row_size, 1u);
+
+		for (u32 row = 0; row < src.height_in_block; row += rows_per_band)
+		{
+			const u32 rows = std::min<u32>(rows_per_band, src.height_in_block - row);
+
+			rsx_subresource_layout band = src;
+			band.height_in_block = static_cast<u16>(rows);
+			band.data = src.data.subspan(size_t{ row } * src_row_size, size_t{ rows } * src_row_size);
+
+			const size_t dst_offset = size_t{ row } * dst_row_size;
+			const size_t dst_length = std::min<size_t>(size_t{ rows } * dst_row_size, dst.size_bytes() - dst_offset);
+
+			enqueue({ dst.subspan(dst_offset, dst_length), { band, format, is_swizzled, vtc_support, dst_row_pitch_multiple_of } });
 		}
 	}
 
 	// Vertex utilities
 	void dma_manager::emulate_as_indexed(void *dst, rsx::primitive_type primitive, u32 count)
 	{
-		if (!g_cfg.video.multithreaded_rsx)
+		if (!m_worker_count || s_is_offload_worker)
 		{
 			write_index_array_for_non_indexed_non_native_primitive_to_buffer(
 				reinterpret_cast<char*>(dst), primitive, count);
 		}
 		else
 		{
-			++m_enqueued_count;
-			m_work_queue.push(dst, primitive, count);
+			enqueue({ dst, primitive, count });
 		}
 	}
 
-	// Synchronization
-	void dma_manager::sync()
+	void dma_manager::convert_vertex_array(gsl::span<gsl::byte> dst, gsl::span<const gsl::byte> src, u32 count, rsx::vertex_base_type type, u32 vector_element_count, u32 attribute_src_stride, u8 dst_stride, bool swap_endianness)
 	{
-		if (LIKELY(m_enqueued_count.load() == m_processed_count))
+		const vertex_convert_args args = { type, 0, vector_element_count, attribute_src_stride, dst_stride, swap_endianness };
+
+		if (!can_offload(count * dst_stride))
+		{
+			write_vertex_array_data_to_buffer(dst, src, count, type, vector_element_count, attribute_src_stride, dst_stride, swap_endianness);
+			return;
+		}
+
+		// Repeating arrays (fewer source vertices than requested) wrap around the source data and cannot be split
+		const u32 src_stride = attribute_src_stride ? attribute_src_stride : rsx::get_vertex_type_size_on_host(type, vector_element_count);
+		if (src.size_bytes() < size_t{ count } * src_stride)
 		{
-			// Nothing to do
+			enqueue({ dst, src, count, args });
 			return;
 		}
 
-		while (m_enqueued_count.load() != m_processed_count)
-			_mm_pause();
+		const u32 vertices_per_band = std::max(band_size / std::max<u32>(src_stride, dst_stride), 1u);
+
+		for (u32 first = 0; first < count; first += vertices_per_band)
+		{
+			const u32 vertices = std::min(vertices_per_band, count - first);
+			enqueue({ dst.subspan(size_t{ first } * dst_stride, size_t{ vertices } * dst_stride), src.subspan(size_t{ first } * src_stride, size_t{ vertices } * src_stride), vertices, args });
+		}
+	}
+
+	// Synchronization
+	dma_manager::fence dma_manager::get_fence() const
+	{
+		fence result = {};
+
+		for (u32 index = 0; index < m_worker_count; ++index)
+		{
+			result[index] = m_workers[index].enqueued_count.load();
+		}
+
+		return result;
+	}
+
+	void dma_manager::wait(const fence& f) const
+	{
+		for (u32 index = 0; index < m_worker_count; ++index)
+		{
+			// Most waits are for a band or two, spin briefly before giving the core away to the workers
+			for (u32 spin = 0; m_workers[index].processed_count.load() < f[index]; ++spin)
+			{
+				if (spin < 16)
+				{
+					busy_wait(500);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+	}
+
+	void dma_manager::sync() const
+	{
+		wait(get_fence());
 	}
 
 	void dma_manager::join()
 	{
-		m_worker_state = thread_state::finished;
+		if (m_worker_state == thread_state::detached)
+		{
+			return;
+		}
+
 		sync();
+		m_worker_state = thread_state::finished;
+
+		// Wake up idle workers so that they can observe the state change, wake packets are not counted as submitted work
+		for (u32 index = 0; index < m_worker_count; ++index)
+		{
+			m_workers[index].work_queue.push();
+		}
+
+		// Wait for the workers to exit, they access the worker contexts until then
+		m_threads.clear();
+
+		m_worker_count = 0;
+		m_worker_state = thread_state::detached;
 	}
 }
@@ -4,18 +4,53 @@
 #include "Utilities/lockless.h"
 #include "Utilities/Thread.h"
 #include "gcm_enums.h"
+#include "Common/TextureUtils.h"
 
 #include <vector>
+#include <array>
+#include <deque>
+#include <functional>
 
 namespace rsx
 {
+	// Offloads RSX CPU work (copies, texture decoding, vertex conversion, readback repitching) to a small set of worker threads.
+	// Large jobs are split into bands that are spread across the workers.
 	class dma_manager
 	{
+	public:
+		static constexpr u32 max_workers = 4;
+
+		// Snapshot of the work submitted to each worker. Waiting on it guarantees that everything submitted before it was taken has completed.
+		using fence = std::array<u64, max_workers>;
+
+	private:
 		enum op
 		{
 			raw_copy = 0,
 			vector_copy = 1,
-			index_emulate = 2
+			index_emulate = 2,
+			texture_decode = 3,
+			vertex_convert = 4,
+			wake = 5 // No work, only wakes the worker up
+		};
+
+		struct texture_decode_args
+		{
+			rsx_subresource_layout layout;
+			int format;
+			bool is_swizzled;
+			bool vtc_support;
+			u32 dst_row_pitch_multiple_of;
+		};
+
+		struct vertex_convert_args
+		{
+			rsx::vertex_base_type type;
+			u32 src_length;
+			u32 vector_element_count;
+			u32 attribute_src_stride;
+			u8 dst_stride;
+			bool swap_endianness;
 		};
 
 		struct transport_packet
@@ -28,6 +63,13 @@ namespace rsx
 			u32 aux_param0;
 			u32 aux_param1;
 
+			texture_decode_args texture;
+			vertex_convert_args vertex;
+
+			transport_packet()
+				: src(nullptr), dst(nullptr), length(0), type(op::wake)
+			{}
+
 			transport_packet(void *_dst, void *_src, u32 len)
 				: src(_src), dst(_dst), length(len), type(op::raw_copy)
 			{}
@@ -39,15 +81,40 @@ namespace rsx
 			transport_packet(void *_dst, rsx::primitive_type prim, u32 len)
 				: dst(_dst), aux_param0(static_cast<u8>(prim)), length(len), type(op::index_emulate)
 			{}
+
+			transport_packet(gsl::span<gsl::byte> _dst, const texture_decode_args& args)
+				: dst(_dst.data()), length(::narrow<u32>(_dst.size_bytes())), texture(args), type(op::texture_decode)
+			{}
+
+			transport_packet(gsl::span<gsl::byte> _dst, gsl::span<const gsl::byte> _src, u32 count, const vertex_convert_args& args)
+				: dst(_dst.data()), src(const_cast<gsl::byte*>(_src.data())), length(count), vertex(args), type(op::vertex_convert)
+			{
+				vertex.src_length = ::narrow<u32>(_src.size_bytes());
+			}
 		};
 
-		lf_queue<transport_packet> m_work_queue;
-		atomic_t<u64> m_enqueued_count{ 0 };
-		volatile u64 m_processed_count = 0;
-		thread_state m_worker_state = thread_state::detached;
+		struct worker_context
+		{
+			lf_queue<transport_packet> work_queue;
+			atomic_t<u64> enqueued_count{ 0 };
+			atomic_t<u64> processed_count{ 0 };
+		};
 
-		// TODO: Improved benchmarks here; value determined by profiling on a Ryzen CPU, rounded to the nearest 512 bytes
-		const u32 max_immediate_transfer_size = 3584;
+		std::array<worker_context, max_workers> m_workers;
+		std::deque<named_thread<std::function<void()>>> m_threads;
+		u32 m_worker_count = 0;
+		atomic_t<u32> m_next_worker{ 0 };
+		atomic_t<thread_state> m_worker_state{ thread_state::detached };
+
+		// Transfers up to this size are done on the calling thread; calibrated against the cost of a queue round trip in init()
+		u32 m_max_immediate_transfer_size = 3584;
+
+		// Target amount of work per packet when a job is split into bands
+		const u32 band_size = 256 * 1024;
+
+		bool can_offload(u32 length) const;
+		void enqueue(transport_packet&& packet);
+		void calibrate();
 
 	public:
 		dma_manager() = default;
@@ -59,11 +126,19 @@ namespace rsx
 		void copy(void *dst, std::vector<u8>& src, u32 length);
 		void copy(void *dst, void *src, u32 length);
 
+		// Texture utilities
+		void upload_texture(gsl::span<gsl::byte> dst, const rsx_subresource_layout& src, int format, bool is_swizzled, bool vtc_support, u32 dst_row_pitch_multiple_of);
+
 		// Vertex utilities
 		void emulate_as_indexed(void *dst, rsx::primitive_type primitive, u32 count);
 
+		// Only D3D12 converts vertex data on the CPU, GL and Vulkan upload it raw and decode it in the vertex shader
+		void convert_vertex_array(gsl::span<gsl::byte> dst, gsl::span<const gsl::byte> src, u32 count, rsx::vertex_base_type type, u32 vector_element_count, u32 attribute_src_stride, u8 dst_stride, bool swap_endianness);
+
 		// Synchronization
-		void sync();
+		fence get_fence() const;
+		void wait(const fence& f) const;
+		void sync() const;
 		void join();
 	};
 
@@ -446,6 +446,12 @@ namespace rsx
 		g_dma_manager.init();
 		m_profiler.enabled = !!g_cfg.video.overlay;
 
+		if (g_cfg.video.frame_timing_log)
+		{
+			const bool json = !!g_cfg.video.frame_timing_log_json;
+			m_frame_timings.open(fs::get_cache_dir() + (json ? "RSX_frame_timings.jsonl" : "RSX_frame_timings.csv"), json);
+		}
+
 		if (!zcull_ctrl)
 		{
 			//Backend did not provide an implementation, provide NULL object
@@ -583,7 +589,10 @@ namespace rsx
 			zcull_ctrl->update(this);
 
 			// Execute FIFO queue
-			run_FIFO();
+			{
+				frame_stage_scope fifo_scope(m_frame_timings, performance_counters.state == FIFO_state::running ? frame_stage::fifo_decode : frame_stage::idle);
+				run_FIFO();
+			}
 
 			if (!Emu.IsRunning())
 			{
@@ -1299,6 +1308,8 @@ namespace rsx
 			return;
 
 		m_graphics_state &= ~(rsx::pipeline_state::vertex_program_dirty);
+
+		frame_stage_scope lookup_scope(m_frame_timings, frame_stage::program_lookup);
 		const u32 transform_program_start = rsx::method_registers.transform_program_start();
 		current_vertex_program.output_mask = rsx::method_registers.vertex_attrib_output_mask();
 		current_vertex_program.skip_vertex_input_check = skip_vertex_inputs;
@@ -1544,6 +1555,8 @@ namespace rsx
 			return;
 
 		m_graphics_state &= ~(rsx::pipeline_state::fragment_program_dirty);
+
+		frame_stage_scope lookup_scope(m_frame_timings, frame_stage::program_lookup);
 		auto &result = current_fragment_program = {};
 
 		const u32 shader_program = rsx::method_registers.shader_program_address();
@@ -2191,6 +2204,8 @@ namespace rsx
 			}
 		}
 
+		m_frame_timings.end_frame(m_draw_calls);
+
 		if (!skip_frame)
 		{
 			// Reset counter
@@ -2272,6 +2287,7 @@ namespace rsx
 
 	void thread::sync()
 	{
+		frame_stage_scope sync_scope(m_frame_timings, frame_stage::flush_wait);
 		zcull_ctrl->sync(this);
 
 		// Fragment constants may have been updated
@@ -2478,6 +2494,8 @@ namespace rsx
 			Emu.Pause();
 		}
 
+		frame_stage_scope flip_scope(m_frame_timings, frame_stage::flip);
+
 		double limit = 0.;
 		switch (g_cfg.video.frame_limit)
 		{
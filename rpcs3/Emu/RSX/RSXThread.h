@@ -12,6 +12,7 @@
 #include "rsx_methods.h"
 #include "rsx_utils.h"
 #include "Overlays/overlays.h"
+#include "Common/frame_timings.h"
 
 #include "Utilities/Thread.h"
 #include "Utilities/geometry.h"
@@ -448,6 +449,7 @@ namespace rsx
 
 		// Profiler
 		rsx::profiling_timer m_profiler;
+		rsx::frame_timing_recorder m_frame_timings;
 
 	public:
 		RsxDmaControl* ctrl = nullptr;
@@ -546,7 +546,7 @@ VKGSRender::VKGSRender() : GSRender()
 	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
 		m_vertex_cache = std::make_unique<vk::null_vertex_cache>();
 	else
-		m_vertex_cache = std::make_unique<vk::weak_vertex_cache>();
+		m_vertex_cache = std::make_unique<vk::persistent_vertex_cache>();
 
 	m_shaders_cache = std::make_unique<vk::shader_cache>(*m_prog_buffer, "vulkan", "v1.8");
 
@@ -1257,6 +1257,7 @@ void VKGSRender::end()
 
 	//Load textures
 	{
+		rsx::frame_stage_scope texture_scope(m_frame_timings, rsx::frame_stage::texture_cache);
 		std::lock_guard lock(m_sampler_mutex);
 		bool update_framebuffer_sourced = false;
 		bool check_for_cyclic_refs = false;
@@ -1272,7 +1273,7 @@ void VKGSRender::end()
 			if (!fs_sampler_state[i])
 				fs_sampler_state[i] = std::make_unique<vk::texture_cache::sampled_image_descriptor>();
 
-			if (m_samplers_dirty || m_textures_dirty[i] ||
+			if (m_samplers_dirty || m_textures_dirty[i] || fs_sampler_state[i]->is_hash_verified ||
 				(update_framebuffer_sourced && fs_sampler_state[i]->upload_context == rsx::texture_upload_context::framebuffer_storage))
 			{
 				auto sampler_state = static_cast<vk::texture_cache::sampled_image_descriptor*>(fs_sampler_state[i].get());
@@ -1390,7 +1391,7 @@ void VKGSRender::end()
 			if (!vs_sampler_state[i])
 				vs_sampler_state[i] = std::make_unique<vk::texture_cache::sampled_image_descriptor>();
 
-			if (m_samplers_dirty || m_vertex_textures_dirty[i] ||
+			if (m_samplers_dirty || m_vertex_textures_dirty[i] || vs_sampler_state[i]->is_hash_verified ||
 				(update_framebuffer_sourced && vs_sampler_state[i]->upload_context == rsx::texture_upload_context::framebuffer_storage))
 			{
 				auto sampler_state = static_cast<vk::texture_cache::sampled_image_descriptor*>(vs_sampler_state[i].get());
@@ -2131,6 +2132,8 @@ void VKGSRender::flush_command_queue(bool hard_sync)
 
 	if (hard_sync)
 	{
+		rsx::frame_stage_scope sync_scope(m_frame_timings, rsx::frame_stage::flush_wait);
+
 		// wait for the latest instruction to execute
 		m_current_command_buffer->pending = true;
 		m_current_command_buffer->reset();
@@ -2208,7 +2211,7 @@ void VKGSRender::advance_queued_frames()
 
 	vk::remove_unused_framebuffers();
 
-	m_vertex_cache->purge();
+	m_vertex_cache->on_frame_end();
 	m_current_frame->tag_frame_end(m_attrib_ring_info.get_current_put_pos_minus_one(),
 		m_vertex_env_ring_info.get_current_put_pos_minus_one(),
 		m_fragment_env_ring_info.get_current_put_pos_minus_one(),
@@ -2382,6 +2385,7 @@ void VKGSRender::do_local_task(rsx::FIFO_state state)
 {
 	if (m_flush_requests.pending())
 	{
+		rsx::frame_stage_scope flush_scope(m_frame_timings, rsx::frame_stage::flush_wait);
 		std::lock_guard lock(m_flush_queue_mutex);
 
 		//TODO: Determine if a hard sync is necessary
@@ -2400,6 +2404,9 @@ void VKGSRender::do_local_task(rsx::FIFO_state state)
 			m_texture_cache.do_update();
 			m_graphics_state &= ~rsx::pipeline_state::framebuffer_reads_dirty;
 		}
+
+		// Move completed speculative readbacks to host memory before the CPU asks for them
+		m_texture_cache.stage_completed_readbacks();
 	}
 
 	rsx::thread::do_local_task(state);
@@ -2448,6 +2455,8 @@ bool VKGSRender::do_method(u32 cmd, u32 arg)
 
 bool VKGSRender::load_program()
 {
+	rsx::frame_stage_scope lookup_scope(m_frame_timings, rsx::frame_stage::program_lookup);
+
 	if (m_graphics_state & rsx::pipeline_state::invalidate_pipeline_bits)
 	{
 		get_current_fragment_program(fs_sampler_state);
@@ -3286,7 +3295,7 @@ void VKGSRender::flip(int buffer, bool emu_flip)
 			}
 			else
 			{
-				const auto overlap_info = m_rtts.get_merged_texture_memory_region(*m_current_command_buffer, absolute_address, buffer_width, buffer_height, buffer_pitch, render_target_texture->get_bpp());
+				const auto& overlap_info = m_rtts.get_merged_texture_memory_region(*m_current_command_buffer, absolute_address, buffer_width, buffer_height, buffer_pitch, render_target_texture->get_bpp());
 				if (!overlap_info.empty() && overlap_info.back().surface == render_target_texture)
 				{
 					// Confirmed to be the newest data source in that range
@@ -3437,10 +3446,21 @@ void VKGSRender::flip(int buffer, bool emu_flip)
 			const auto num_misses = m_texture_cache.get_num_cache_misses();
 			const auto num_unavoidable = m_texture_cache.get_num_unavoidable_hard_faults();
 			const auto cache_miss_ratio = (u32)ceil(m_texture_cache.get_cache_miss_ratio() * 100);
+			const auto num_lookup_allocations = m_texture_cache.get_num_lookup_allocations();
+			const auto num_hash_misses = m_texture_cache.get_num_hash_verification_misses();
+			const auto num_protect_requests = rsx::memory_protection_batch::get_num_requested();
+			const auto num_protect_calls = rsx::memory_protection_batch::get_num_issued();
+			const auto num_staged_readbacks = m_texture_cache.get_num_staged_readbacks();
+			const auto program_lookups = m_prog_buffer->get_lookup_cache_statistics();
 			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 144, direct_fbo->width(), direct_fbo->height(), fmt::format("Unreleased textures: %8d", num_dirty_textures));
 			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 162, direct_fbo->width(), direct_fbo->height(), fmt::format("Texture cache memory: %7dM", texture_memory_size));
 			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 180, direct_fbo->width(), direct_fbo->height(), fmt::format("Temporary texture memory: %3dM", tmp_texture_memory_size));
 			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 198, direct_fbo->width(), direct_fbo->height(), fmt::format("Flush requests: %13d  = %2d (%3d%%) hard faults, %2d unavoidable, %2d misprediction(s), %2d speculation(s)", num_flushes, num_misses, cache_miss_ratio, num_unavoidable, num_mispredict, num_speculate));
+			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 216, direct_fbo->width(), direct_fbo->height(), fmt::format("Lookup allocations: %9d", num_lookup_allocations));
+			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 234, direct_fbo->width(), direct_fbo->height(), fmt::format("Hash verification misses: %3d", num_hash_misses));
+			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 252, direct_fbo->width(), direct_fbo->height(), fmt::format("Page protection calls: %5d (%d requested)", num_protect_calls, num_protect_requests));
+			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 270, direct_fbo->width(), direct_fbo->height(), fmt::format("Staged readbacks: %11d", num_staged_readbacks));
+			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 288, direct_fbo->width(), direct_fbo->height(), fmt::format("Program lookups: %12d  = %d cached", program_lookups.first + program_lookups.second, program_lookups.first));
 		}
 
 		vk::change_image_layout(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, present_layout, subres);
@@ -3464,6 +3484,7 @@ void VKGSRender::flip(int buffer, bool emu_flip)
 	m_setup_time = 0;
 	m_vertex_upload_time = 0;
 	m_textures_upload_time = 0;
+	m_prog_buffer->reset_lookup_cache_statistics();
 }
 
 bool VKGSRender::scaled_image_from_memory(rsx::blit_src_info& src, rsx::blit_dst_info& dst, bool interpolate)
@@ -3138,13 +3138,22 @@ public:
 			{
 				type = domain;
 				m_source = source;
+				m_compiled.clear();
+			}
+
+			// Creates the shader from previously compiled SPIR-V; compile() will only create the module
+			void create(::glsl::program_domain domain, const std::string& source, const std::vector<u32>& spirv)
+			{
+				type = domain;
+				m_source = source;
+				m_compiled = spirv;
 			}
 
 			VkShaderModule compile()
 			{
 				verify(HERE), m_handle == VK_NULL_HANDLE;
 
-				if (!vk::compile_glsl_to_spv(m_source, type, m_compiled))
+				if (m_compiled.empty() && !vk::compile_glsl_to_spv(m_source, type, m_compiled))
 				{
 					std::string shader_type = type == ::glsl::program_domain::glsl_vertex_program ? "vertex" :
 						type == ::glsl::program_domain::glsl_fragment_program ? "fragment" : "compute";
@@ -3183,7 +3192,7 @@ public:
 				return m_source;
 			}
 
-			const std::vector<u32> get_compiled() const
+			const std::vector<u32>& get_compiled() const
 			{
 				return m_compiled;
 			}
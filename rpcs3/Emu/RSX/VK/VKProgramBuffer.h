@@ -91,6 +91,142 @@ struct VKTraits
 		vertexProgramData.Compile();
 	}
 
+	static
+	bool load_fragment_program(const rsx::shader_cache_archive& archive, u64 key, const RSXFragmentProgram& /*RSXFP*/, fragment_program_type& fragmentProgramData, size_t ID)
+	{
+		std::vector<u8> data;
+		if (!archive.read(rsx::shader_cache_archive::decompiled_fragment_program, get_fragment_program_archive_key(key), data))
+		{
+			return false;
+		}
+
+		rsx::shader_cache_archive::object_reader reader(data);
+		std::string source;
+		std::vector<u32> spirv;
+		reader.read(source);
+		reader.read(spirv);
+		reader.read(fragmentProgramData.FragmentConstantOffsetCache);
+		reader.read(fragmentProgramData.output_color_masks);
+		read_program_inputs(reader, fragmentProgramData.uniforms);
+
+		if (!reader.valid() || spirv.empty())
+		{
+			LOG_ERROR(RSX, "Decompiled fragment program 0x%llx is corrupt", key);
+			fragmentProgramData.FragmentConstantOffsetCache.clear();
+			fragmentProgramData.output_color_masks = {};
+			fragmentProgramData.uniforms.clear();
+			return false;
+		}
+
+		fragmentProgramData.shader.create(::glsl::program_domain::glsl_fragment_program, source, spirv);
+		fragmentProgramData.id = static_cast<u32>(ID);
+		fragmentProgramData.Compile();
+		return true;
+	}
+
+	static
+	bool load_vertex_program(const rsx::shader_cache_archive& archive, u64 key, const RSXVertexProgram& /*RSXVP*/, vertex_program_type& vertexProgramData, size_t ID)
+	{
+		std::vector<u8> data;
+		if (!archive.read(rsx::shader_cache_archive::decompiled_vertex_program, key, data))
+		{
+			return false;
+		}
+
+		rsx::shader_cache_archive::object_reader reader(data);
+		std::string source;
+		std::vector<u32> spirv;
+		reader.read(source);
+		reader.read(spirv);
+		read_program_inputs(reader, vertexProgramData.uniforms);
+
+		if (!reader.valid() || spirv.empty())
+		{
+			LOG_ERROR(RSX, "Decompiled vertex program 0x%llx is corrupt", key);
+			vertexProgramData.uniforms.clear();
+			return false;
+		}
+
+		vertexProgramData.shader.create(::glsl::program_domain::glsl_vertex_program, source, spirv);
+		vertexProgramData.id = static_cast<u32>(ID);
+		vertexProgramData.Compile();
+		return true;
+	}
+
+	static
+	void store_fragment_program(rsx::shader_cache_archive& archive, u64 key, const fragment_program_type& fragmentProgramData)
+	{
+		rsx::shader_cache_archive::object_writer writer;
+		writer.write(fragmentProgramData.shader.get_source());
+		writer.write(fragmentProgramData.shader.get_compiled());
+		writer.write(fragmentProgramData.FragmentConstantOffsetCache);
+		writer.write(fragmentProgramData.output_color_masks);
+		write_program_inputs(writer, fragmentProgramData.uniforms);
+		archive.append(rsx::shader_cache_archive::decompiled_fragment_program, get_fragment_program_archive_key(key), writer.data().data(), ::size32(writer.data()));
+	}
+
+	static
+	void store_vertex_program(rsx::shader_cache_archive& archive, u64 key, const vertex_program_type& vertexProgramData)
+	{
+		rsx::shader_cache_archive::object_writer writer;
+		writer.write(vertexProgramData.shader.get_source());
+		writer.write(vertexProgramData.shader.get_compiled());
+		write_program_inputs(writer, vertexProgramData.uniforms);
+		archive.append(rsx::shader_cache_archive::decompiled_vertex_program, key, writer.data().data(), ::size32(writer.data()));
+	}
+
+	// Folds the device and configuration properties that affect the generated fragment shader into key
+	static
+	u64 get_fragment_program_archive_key(u64 key)
+	{
+		const auto pdev = vk::get_current_renderer();
+		const bool native_half = !g_cfg.video.disable_native_float16 && pdev->get_shader_types_support().allow_float16;
+		const bool emulate_depth_compare = !pdev->get_formats_support().d24_unorm_s8;
+		const bool emulate_coverage = g_cfg.video.antialiasing_level == msaa_level::none;
+
+		const std::array<u64, 2> data = { key, u64{ native_half } | u64{ emulate_depth_compare } << 1 | u64{ emulate_coverage } << 2 };
+		return rpcs3::hash_struct(data);
+	}
+
+	// Binding metadata only; the bound resource fields are filled at draw time
+	static
+	void write_program_inputs(rsx::shader_cache_archive::object_writer& writer, const std::vector<vk::glsl::program_input>& inputs)
+	{
+		writer.write(::size32(inputs));
+
+		for (const auto& input : inputs)
+		{
+			writer.write(input.domain);
+			writer.write(input.type);
+			writer.write(input.location);
+			writer.write(input.name);
+		}
+	}
+
+	static
+	void read_program_inputs(rsx::shader_cache_archive::object_reader& reader, std::vector<vk::glsl::program_input>& inputs)
+	{
+		u32 count = 0;
+		reader.read(count);
+
+		// Each entry takes at least 16 bytes, do not trust a corrupt count
+		if (count > reader.remaining() / 16)
+		{
+			return;
+		}
+
+		inputs.resize(count);
+
+		for (auto& input : inputs)
+		{
+			input = {};
+			reader.read(input.domain);
+			reader.read(input.type);
+			reader.read(input.location);
+			reader.read(input.name);
+		}
+	}
+
 	static
 	void validate_pipeline_properties(const VKVertexProgram&, const VKFragmentProgram &fp, vk::pipeline_props& properties)
 	{
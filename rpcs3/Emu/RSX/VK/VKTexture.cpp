@@ -527,8 +527,7 @@ namespace vk
 			VkBuffer buffer_handle = upload_heap.heap->value;
 
 			gsl::span<gsl::byte> mapped{ (gsl::byte*)mapped_buffer, ::narrow<int>(image_linear_size) };
-			upload_texture_subresource(mapped, layout, format, is_swizzled, false, 256);
-			upload_heap.unmap();
+			rsx::g_dma_manager.upload_texture(mapped, layout, format, is_swizzled, false, 256);
 
 			VkBufferImageCopy copy_info = {};
 			copy_info.bufferOffset = offset_in_buffer;
@@ -567,6 +566,10 @@ namespace vk
 
 			mipmap_level++;
 		}
+
+		// The copies are only executed once the command buffer is submitted, the decoded data must be in place by then
+		rsx::g_dma_manager.sync();
+		upload_heap.unmap();
 	}
 
 	VkComponentMapping apply_swizzle_remap(const std::array<VkComponentSwizzle, 4>& base_remap, const std::pair<std::array<u8, 4>, std::array<u8, 4>>& remap_vector)
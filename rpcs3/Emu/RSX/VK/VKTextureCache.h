@@ -325,10 +325,32 @@ namespace vk
 			return dma_buffer->map(offset, size);
 		}
 
-		void finish_flush()
+		void unmap_synchronized()
 		{
 			dma_buffer->unmap();
+		}
+
+		bool is_readback_complete() const
+		{
+			return dma_fence != VK_NULL_HANDLE && vkGetEventStatus(*m_device, dma_fence) == VK_EVENT_SET;
+		}
+
+		bool supports_readback_staging() const
+		{
+			return true;
+		}
 
+		u32 get_readback_buffer_size() const
+		{
+			return dma_buffer->size();
+		}
+
+		void convert_staged_data(u8* /*data*/, u32 /*length*/)
+		{
+		}
+
+		void finish_flush(bool /*from_staged_data*/)
+		{
 			if (context == rsx::texture_upload_context::framebuffer_storage)
 			{
 				// Update memory tag
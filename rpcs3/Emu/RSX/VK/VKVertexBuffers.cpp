@@ -224,6 +224,8 @@ namespace
 
 vk::vertex_upload_info VKGSRender::upload_vertex_data()
 {
+	rsx::frame_stage_scope upload_scope(m_frame_timings, rsx::frame_stage::vertex_upload);
+
 	draw_command_visitor visitor(m_index_buffer_ring_info, m_vertex_layout);
 	auto result = std::visit(visitor, get_draw_command(rsx::method_registers));
 
@@ -242,11 +244,13 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 	u32 persistent_range_base = UINT32_MAX, volatile_range_base = UINT32_MAX;
 	size_t persistent_offset = UINT64_MAX, volatile_offset = UINT64_MAX;
 
+	// Keep the vertex cache informed of how far the heap has moved
+	m_vertex_cache->set_heap_position(m_attrib_ring_info.m_put_pos, m_attrib_ring_info.size());
+
 	if (required.first > 0)
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
-		//TODO: make vertex cache keep local data beyond frame boundaries and hook notify command
 		bool in_cache = false;
 		bool to_store = false;
 		u32  storage_address = UINT32_MAX;
@@ -254,8 +258,10 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 		if (m_vertex_layout.interleaved_blocks.size() == 1 &&
 			rsx::method_registers.current_draw_clause.command != rsx::draw_command::inlined_array)
 		{
-			const auto data_offset = (vertex_base * m_vertex_layout.interleaved_blocks[0].attribute_stride);
-			storage_address = m_vertex_layout.interleaved_blocks[0].real_offset_address + data_offset;
+			// Key on the exact source range copied by write_vertex_data_to_memory
+			const auto& block = m_vertex_layout.interleaved_blocks[0];
+			const auto range = block.calculate_required_range(vertex_base, vertex_count);
+			storage_address = block.real_offset_address + (range.first * block.attribute_stride);
 
 			if (auto cached = m_vertex_cache->find_vertex_range(storage_address, VK_FORMAT_R8_UINT, required.first))
 			{
@@ -8,8 +8,11 @@
 #include "Emu/Cell/Modules/cellMsgDialog.h"
 #include "Emu/System.h"
 #include "Common/texture_cache_checker.h"
+#include "Common/shader_cache_archive.h"
+#include "Common/protection_batch.h"
 
 #include "rsx_utils.h"
+#include "xxhash.h"
 #include <thread>
 #include <chrono>
 
@@ -34,7 +37,7 @@ namespace rsx
 		verify(HERE), range.is_page_range();
 
 		//LOG_ERROR(RSX, "memory_protect(0x%x, 0x%x, %x)", static_cast<u32>(range.start), static_cast<u32>(range.length()), static_cast<u32>(prot));
-		utils::memory_protect(vm::base(range.start), range.length(), prot);
+		memory_protection_batch::protect(range, prot);
 
 #ifdef TEXTURE_CACHE_DEBUG
 		tex_cache_checker.set_protection(range, prot);
@@ -55,6 +58,17 @@ namespace rsx
 
 		bool locked = false;
 
+		// Hash-verified sections hold their read-only lock without protecting any pages.
+		// Instead, a hash of the section contents taken at lock time is compared against memory on use.
+		bool hash_verified = false;
+		bool hash_locked = false;
+		u64 content_hash = 0;
+
+		inline u64 compute_content_hash() const
+		{
+			return XXH64(get_ptr<const void>(cpu_range.start), cpu_range.length(), 0);
+		}
+
 		inline void init_lockable_range(const address_range &range)
 		{
 			locked_range = range.to_page_range();
@@ -98,6 +112,8 @@ namespace rsx
 
 			protection = utils::protection::rw;
 			locked = false;
+			hash_verified = false;
+			hash_locked = false;
 
 			init_lockable_range(cpu_range);
 		}
@@ -120,17 +136,29 @@ namespace rsx
 			verify(HERE), locked_range.is_page_range();
 			AUDIT( !confirmed_range.valid() || confirmed_range.inside(cpu_range) );
 
+			// Hash verification only replaces read-only locks taken on an unlocked section; a page guard is never traded for it
+			const bool use_hash = hash_verified && new_prot == utils::protection::ro && (!locked || hash_locked);
+
 #ifdef TEXTURE_CACHE_DEBUG
 			if (new_prot != protection || force)
 			{
-				if (locked && !force) // When force=true, it is the responsibility of the caller to remove this section from the checker refcounting
+				if (locked && !force && !hash_locked) // When force=true, it is the responsibility of the caller to remove this section from the checker refcounting
 					tex_cache_checker.remove(locked_range, protection);
-				if (new_prot != utils::protection::rw)
+				if (new_prot != utils::protection::rw && !use_hash)
 					tex_cache_checker.add(locked_range, new_prot);
 			}
 #endif // TEXTURE_CACHE_DEBUG
 
-			rsx::memory_protect(locked_range, new_prot);
+			if (use_hash)
+			{
+				content_hash = compute_content_hash();
+			}
+			else if (!hash_locked || new_prot != utils::protection::rw)
+			{
+				rsx::memory_protect(locked_range, new_prot);
+			}
+
+			hash_locked = use_hash;
 			protection = new_prot;
 			locked = (protection != utils::protection::rw);
 
@@ -156,7 +184,7 @@ namespace rsx
 
 #ifdef TEXTURE_CACHE_DEBUG
 			// We need to remove the lockable range from page_info as we will be re-protecting with force==true
-			if (locked)
+			if (locked && !hash_locked)
 				tex_cache_checker.remove(locked_range, protection);
 #endif
 
@@ -189,13 +217,54 @@ namespace rsx
 		inline void discard()
 		{
 #ifdef TEXTURE_CACHE_DEBUG
-			if (locked)
+			if (locked && !hash_locked)
 				tex_cache_checker.remove(locked_range, protection);
 #endif
 
 			protection = utils::protection::rw;
 			confirmed_range.invalidate();
 			locked = false;
+			hash_locked = false;
+		}
+
+		/**
+		 * Hash verification
+		 */
+		// Selects hash verification for the next read-only lock; must be set while unlocked
+		inline void set_hash_verified(bool enable)
+		{
+			AUDIT(!locked);
+			hash_verified = enable;
+		}
+
+		// True if this section is locked without page protection and must be verified before use
+		inline bool is_hash_guarded() const
+		{
+			return hash_locked;
+		}
+
+		// Returns false if the memory backing this section was written since it was locked
+		bool test_content_hash() const
+		{
+			AUDIT(hash_locked);
+			return compute_content_hash() == content_hash;
+		}
+
+		// Replaces the hash lock with page protection, returns false if the memory was written since the section was locked
+		bool protect_hash_locked_range()
+		{
+			AUDIT(hash_locked);
+
+			// Protect before testing, so that a write can't slip in between
+			rsx::memory_protect(locked_range, protection);
+
+#ifdef TEXTURE_CACHE_DEBUG
+			tex_cache_checker.add(locked_range, protection);
+#endif // TEXTURE_CACHE_DEBUG
+
+			hash_locked = false;
+			hash_verified = false;
+			return compute_content_hash() == content_hash;
 		}
 
 		inline const address_range& get_bounds(section_bounds bounds) const
@@ -417,9 +486,112 @@ namespace rsx
 		std::string root_path;
 		std::string pipeline_class_name;
 		std::unordered_map<u64, std::vector<u8>> fragment_program_data;
+		shared_mutex fragment_program_data_mutex;
+
+		shader_cache_archive m_archive;
 
 		backend_storage& m_storage;
 
+		static u64 get_pipeline_key(const pipeline_data& data)
+		{
+			u64 state_hash = 0;
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_alphakill_mask);
+			state_hash ^= rpcs3::hash_base<u64>(data.fp_zfunc_mask);
+
+			const std::array<u64, 4> key = { data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, state_hash };
+			return rpcs3::hash_struct(key);
+		}
+
+		bool open_archive()
+		{
+			if (m_archive.is_open())
+			{
+				return true;
+			}
+
+			const std::string class_path = root_path + "/pipelines/" + pipeline_class_name;
+			const std::string archive_path = class_path + "/" + version_prefix + ".pak";
+
+			if (!fs::is_dir(class_path))
+			{
+				fs::create_path(class_path);
+			}
+
+			if (!m_archive.open(archive_path))
+			{
+				return false;
+			}
+
+			// Older builds stored one file per object, move them into the archive
+			const std::string legacy_path = class_path + "/" + version_prefix;
+
+			if (fs::is_dir(legacy_path))
+			{
+				u32 imported = 0;
+
+				for (const auto& entry : fs::dir(legacy_path))
+				{
+					if (entry.is_directory || entry.size != sizeof(pipeline_data))
+						continue;
+
+					pipeline_data data;
+					if (!fs::file(legacy_path + "/" + entry.name).read(data))
+						continue;
+
+					std::vector<u8> program;
+					read_program(shader_cache_archive::vertex_program, data.vertex_program_hash, "vp", program);
+					read_program(shader_cache_archive::fragment_program, data.fragment_program_hash, "fp", program);
+
+					imported += m_archive.append(shader_cache_archive::pipeline, get_pipeline_key(data), &data, sizeof(pipeline_data));
+				}
+
+				LOG_NOTICE(RSX, "shader cache: imported %u pipeline objects from %s", imported, legacy_path);
+
+				// Keep the old files, but don't import them again on the next run
+				if (!fs::rename(legacy_path, legacy_path + ".imported", false))
+				{
+					LOG_WARNING(RSX, "shader cache: failed to rename %s (%s)", legacy_path, fs::g_tls_error);
+				}
+
+				// Reopen so that the imported objects are part of the mapped archive
+				if (!m_archive.open(archive_path))
+				{
+					return false;
+				}
+			}
+
+			// Let the program cache reuse decompiled programs stored by earlier runs
+			m_storage.set_program_archive(&m_archive);
+			return true;
+		}
+
+		// Reads a program from the archive, falling back to (and importing) the loose file written by older builds
+		void read_program(shader_cache_archive::object_type type, u64 program_hash, const char* extension, std::vector<u8>& data)
+		{
+			if (m_archive.read(type, program_hash, data))
+			{
+				return;
+			}
+
+			data.clear();
+
+			if (fs::file f{ root_path + "/raw/" + fmt::format("%llX.%s", program_hash, extension) })
+			{
+				f.read<u8>(data, f.size());
+				m_archive.append(type, program_hash, data.data(), ::size32(data));
+			}
+		}
+
 	public:
 
 		struct progress_dialog_helper
@@ -521,38 +693,28 @@ namespace rsx
 				return;
 			}
 
-			std::string directory_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
-
-			if (!fs::is_dir(directory_path))
+			if (!open_archive())
 			{
-				fs::create_path(directory_path);
-				fs::create_path(root_path + "/raw");
-
 				return;
 			}
 
-			fs::dir root = fs::dir(directory_path);
-
-			u32 entry_count = 0;
-			std::vector<fs::dir_entry> entries;
-			for (auto It = root.begin(); It != root.end(); ++It, entry_count++)
+			std::vector<pipeline_data> entries;
+			m_archive.for_each(shader_cache_archive::pipeline, [&](u64 /*key*/, const u8* data, u32 size)
 			{
-				fs::dir_entry tmp = *It;
-
-				if (tmp.name == "." || tmp.name == "..")
-					continue;
+				if (size != sizeof(pipeline_data))
+				{
+					LOG_ERROR(RSX, "Cached pipeline object is not binary compatible with the current shader cache");
+					return;
+				}
 
-				entries.push_back(tmp);
-			}
+				entries.emplace_back();
+				std::memcpy(&entries.back(), data, sizeof(pipeline_data));
+			});
 
-			if ((entry_count = (u32)entries.size()) <= 2)
+			u32 entry_count = ::size32(entries);
+			if (!entry_count)
 				return;
 
-			root.rewind();
-
-			// Invalid pipeline entries to be removed
-			std::vector<std::string> invalid_entries;
-
 			// Progress dialog
 			std::unique_ptr<progress_dialog_helper> fallback_dlg;
 			if (!dlg)
@@ -571,30 +733,44 @@ namespace rsx
 			unsigned nb_threads = std::thread::hardware_concurrency();
 			std::vector<std::thread> worker_threads(nb_threads);
 
-			// Preload everything needed to compile the shaders
-			// Can probably be parallelized too, but since it's mostly reading files it's probably not worth it
-			std::vector<std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram>> unpacked;
+			// Fetch the programs referenced by every pipeline; the lookups are independent so they are spread across all threads
+			std::vector<std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram>> unpacked(entry_count);
+			{
+				atomic_t<u32> next_entry(0);
+				auto unpack_worker = [&]()
+				{
+					u32 pos;
+					while (((pos = next_entry++) < entry_count) && !Emu.IsStopped())
+					{
+						unpacked[pos] = unpack(entries[pos]);
+					}
+				};
+
+				for (std::thread& worker_thread : worker_threads)
+					worker_thread = std::thread(unpack_worker);
+
+				for (std::thread& worker_thread : worker_threads)
+					worker_thread.join();
+			}
+
+			// Program decompilation is not thread safe and has to run serially
 			std::chrono::time_point<steady_clock> last_update;
 			u32 processed_since_last_update = 0;
+			u32 invalid_entries = 0;
 
 			for (u32 i = 0; (i < entry_count) && !Emu.IsStopped(); i++)
 			{
-				fs::dir_entry tmp = entries[i];
+				auto& entry = unpacked[i];
 
-				const auto filename = directory_path + "/" + tmp.name;
-				std::vector<u8> bytes;
-				fs::file f(filename);
-				if (f.size() != sizeof(pipeline_data))
+				if (std::get<1>(entry).data.empty() || !std::get<2>(entry).ucode_length)
 				{
-					LOG_ERROR(RSX, "Cached pipeline object %s is not binary compatible with the current shader cache", tmp.name.c_str());
-					invalid_entries.push_back(filename);
-					continue;
+					LOG_ERROR(RSX, "Cached pipeline object references programs missing from the shader cache");
+					invalid_entries++;
+				}
+				else
+				{
+					m_storage.preload_programs(std::get<1>(entry), std::get<2>(entry));
 				}
-				f.read<u8>(bytes, f.size());
-
-				auto entry = unpack(*(pipeline_data*)bytes.data());
-				m_storage.preload_programs(std::get<1>(entry), std::get<2>(entry));
-				unpacked.push_back(entry);
 
 				// Only update the screen at about 10fps since updating it everytime slows down the process
 				std::chrono::time_point<steady_clock> now = std::chrono::steady_clock::now();
@@ -608,6 +784,16 @@ namespace rsx
 				}
 			}
 
+			if (invalid_entries)
+			{
+				unpacked.erase(std::remove_if(unpacked.begin(), unpacked.end(), [](const auto& entry)
+				{
+					return std::get<1>(entry).data.empty() || !std::get<2>(entry).ucode_length;
+				}), unpacked.end());
+
+				LOG_NOTICE(RSX, "shader cache: %d entries were skipped", invalid_entries);
+			}
+
 			// Account for any invalid entries
 			entry_count = u32(unpacked.size());
 
@@ -674,16 +860,6 @@ namespace rsx
 				}
 			}
 
-			if (!invalid_entries.empty())
-			{
-				for (const auto &filename : invalid_entries)
-				{
-					fs::remove_file(filename);
-				}
-
-				LOG_NOTICE(RSX, "shader cache: %d entries were marked as invalid and removed", invalid_entries.size());
-			}
-
 			dlg->refresh();
 			dlg->close();
 		}
@@ -701,49 +877,34 @@ namespace rsx
 				return;
 			}
 
+			if (!open_archive())
+			{
+				return;
+			}
+
 			pipeline_data data = pack(pipeline, vp, fp);
-			std::string fp_name = root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash);
-			std::string vp_name = root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash);
 
-			if (!fs::is_file(fp_name))
+			if (!m_archive.contains(shader_cache_archive::fragment_program, data.fragment_program_hash))
 			{
-				fs::file(fp_name, fs::rewrite).write(fp.addr, fp.ucode_length);
+				m_archive.append(shader_cache_archive::fragment_program, data.fragment_program_hash, fp.addr, fp.ucode_length);
 			}
 
-			if (!fs::is_file(vp_name))
+			if (!m_archive.contains(shader_cache_archive::vertex_program, data.vertex_program_hash))
 			{
-				fs::file(vp_name, fs::rewrite).write<u32>(vp.data);
+				m_archive.append(shader_cache_archive::vertex_program, data.vertex_program_hash, vp.data.data(), ::size32(vp.data) * sizeof(u32));
 			}
 
-			u64 state_hash = 0;
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_alphakill_mask);
-			state_hash ^= rpcs3::hash_base<u64>(data.fp_zfunc_mask);
-
-			std::string pipeline_file_name = fmt::format("%llX+%llX+%llX+%llX.bin", data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, state_hash);
-			std::string pipeline_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix + "/" + pipeline_file_name;
-			fs::file(pipeline_path, fs::rewrite).write(&data, sizeof(pipeline_data));
+			m_archive.append(shader_cache_archive::pipeline, get_pipeline_key(data), &data, sizeof(pipeline_data));
 		}
 
 		RSXVertexProgram load_vp_raw(u64 program_hash)
 		{
-			std::vector<u32> data;
-			std::string filename = fmt::format("%llX.vp", program_hash);
-
-			fs::file f(root_path + "/raw/" + filename);
-			f.read<u32>(data, f.size() / sizeof(u32));
+			std::vector<u8> bytes;
+			read_program(shader_cache_archive::vertex_program, program_hash, "vp", bytes);
 
 			RSXVertexProgram vp = {};
-			vp.data = data;
+			vp.data.resize(bytes.size() / sizeof(u32));
+			std::memcpy(vp.data.data(), bytes.data(), vp.data.size() * sizeof(u32));
 			vp.skip_vertex_input_check = true;
 
 			return vp;
@@ -751,21 +912,34 @@ namespace rsx
 
 		RSXFragmentProgram load_fp_raw(u64 program_hash)
 		{
+			RSXFragmentProgram fp = {};
+
+			{
+				reader_lock lock(fragment_program_data_mutex);
+				const auto found = fragment_program_data.find(program_hash);
+
+				if (found != fragment_program_data.end())
+				{
+					fp.addr = found->second.data();
+					fp.ucode_length = (u32)found->second.size();
+					return fp;
+				}
+			}
+
 			std::vector<u8> data;
-			std::string filename = fmt::format("%llX.fp", program_hash);
+			read_program(shader_cache_archive::fragment_program, program_hash, "fp", data);
 
-			fs::file f(root_path + "/raw/" + filename);
-			f.read<u8>(data, f.size());
+			// Another loader thread may have inserted the same program meanwhile, emplace keeps the first one
+			std::lock_guard lock(fragment_program_data_mutex);
+			const auto found = fragment_program_data.emplace(program_hash, std::move(data)).first;
 
-			RSXFragmentProgram fp = {};
-			fragment_program_data[program_hash] = data;
-			fp.addr = fragment_program_data[program_hash].data();
-			fp.ucode_length = (u32)data.size();
+			fp.addr = found->second.data();
+			fp.ucode_length = (u32)found->second.size();
 
 			return fp;
 		}
 
-		std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram> unpack(pipeline_data &data)
+		std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram> unpack(const pipeline_data &data)
 		{
 			RSXVertexProgram vp = load_vp_raw(data.vertex_program_hash);
 			RSXFragmentProgram fp = load_fp_raw(data.fragment_program_hash);
@@ -872,11 +1046,14 @@ namespace rsx
 			virtual storage_type* find_vertex_range(uintptr_t /*local_addr*/, upload_format, u32 /*data_length*/) { return nullptr; }
 			virtual void store_range(uintptr_t /*local_addr*/, upload_format, u32 /*data_length*/, u32 /*offset_in_heap*/) {}
 			virtual void purge() {}
+
+			// Reports the write position of the heap holding the cached data; called before every lookup
+			virtual void set_heap_position(size_t /*put_pos*/, size_t /*heap_size*/) {}
+			virtual void on_frame_end() { purge(); }
 		};
 
 		// A weak vertex cache with no data checks or memory range locks
 		// Of limited use since contents are only guaranteed to be valid once per frame
-		// TODO: Strict vertex cache with range locks
 		template <typename upload_format>
 		struct uploaded_range
 		{
@@ -926,5 +1103,153 @@ namespace rsx
 				vertex_ranges.clear();
 			}
 		};
+
+		// A vertex cache whose entries outlive the frame.
+		// Cached data stays in the vertex ring heap, so an entry is dropped as soon as the heap write position is half a heap
+		// past it; the other half is headroom for frames still in flight. This is checked on every upload, and the cache is
+		// emptied whenever a frame has written more than an eighth of the heap. The source memory is hashed when an entry is
+		// stored, and checked again on the first use of the entry in every frame.
+		template <typename upload_format>
+		class persistent_vertex_cache : public default_vertex_cache<uploaded_range<upload_format>, upload_format>
+		{
+			using storage_type = uploaded_range<upload_format>;
+
+			struct cache_entry : storage_type
+			{
+				u64 data_hash;
+				u64 heap_position; // Absolute heap position at or before the start of the data
+				u64 verified_frame;
+			};
+
+		private:
+			std::unordered_map<uintptr_t, std::vector<cache_entry>> vertex_ranges;
+
+			// Stored entries in heap order, oldest first
+			std::deque<std::pair<u64, uintptr_t>> m_store_order;
+
+			u64 m_heap_position = 0; // Total distance advanced by the heap write position
+			u64 m_frame_start_position = 0;
+			size_t m_last_put_pos = 0;
+			size_t m_heap_size = 0;
+			u64 m_frame = 0;
+
+			static u64 hash_range(uintptr_t local_addr, u32 data_length)
+			{
+				return XXH64(vm::base(static_cast<u32>(local_addr)), data_length, 0);
+			}
+
+			bool is_resident(u64 heap_position) const
+			{
+				return (m_heap_position - heap_position) <= (m_heap_size / 2);
+			}
+
+			// Drops the entries the heap write position has moved too far past
+			void evict_overrun()
+			{
+				while (!m_store_order.empty() && !is_resident(m_store_order.front().first))
+				{
+					const auto found = vertex_ranges.find(m_store_order.front().second);
+					m_store_order.pop_front();
+
+					if (found == vertex_ranges.end())
+					{
+						continue;
+					}
+
+					auto& entries = found->second;
+					entries.erase(std::remove_if(entries.begin(), entries.end(), [this](const cache_entry& e) { return !is_resident(e.heap_position); }), entries.end());
+
+					if (entries.empty())
+					{
+						vertex_ranges.erase(found);
+					}
+				}
+			}
+
+		public:
+			storage_type* find_vertex_range(uintptr_t local_addr, upload_format fmt, u32 data_length) override
+			{
+				const auto found = vertex_ranges.find(local_addr);
+				if (found == vertex_ranges.end())
+				{
+					return nullptr;
+				}
+
+				auto& entries = found->second;
+				for (auto It = entries.begin(); It != entries.end(); ++It)
+				{
+					if (It->buffer_format != fmt || It->data_length != data_length)
+					{
+						continue;
+					}
+
+					if (It->verified_frame != m_frame)
+					{
+						if (hash_range(local_addr, data_length) != It->data_hash)
+						{
+							entries.erase(It);
+							return nullptr;
+						}
+
+						It->verified_frame = m_frame;
+					}
+
+					return &*It;
+				}
+
+				return nullptr;
+			}
+
+			void store_range(uintptr_t local_addr, upload_format fmt, u32 data_length, u32 offset_in_heap) override
+			{
+				cache_entry v = {};
+				v.buffer_format = fmt;
+				v.data_length = data_length;
+				v.local_address = local_addr;
+				v.offset_in_heap = offset_in_heap;
+				v.data_hash = hash_range(local_addr, data_length);
+				v.heap_position = m_heap_position;
+				v.verified_frame = m_frame;
+
+				vertex_ranges[local_addr].push_back(v);
+				m_store_order.emplace_back(v.heap_position, local_addr);
+			}
+
+			void purge() override
+			{
+				vertex_ranges.clear();
+				m_store_order.clear();
+			}
+
+			void set_heap_position(size_t put_pos, size_t heap_size) override
+			{
+				if (heap_size != m_heap_size)
+				{
+					// The heap was recreated
+					purge();
+					m_heap_size = heap_size;
+					m_last_put_pos = put_pos;
+					return;
+				}
+
+				m_heap_position += (put_pos + heap_size - m_last_put_pos) % heap_size;
+				m_last_put_pos = put_pos;
+
+				// A frame eating through more than an eighth of the heap could overrun data still referenced by frames in flight
+				if ((m_heap_position - m_frame_start_position) > (m_heap_size / 8))
+				{
+					purge();
+					return;
+				}
+
+				evict_overrun();
+			}
+
+			void on_frame_end() override
+			{
+				m_frame_start_position = m_heap_position;
+				m_frame++;
+			}
+		};
 	}
 }
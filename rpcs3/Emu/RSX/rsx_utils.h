@@ -907,6 +907,12 @@ namespace rsx
 			std::swap(_data, other._data);
 		}
 
+		// Geometric growth; arrays filled one element at a time (inline vertex data) would otherwise be reallocated every few elements
+		void grow()
+		{
+			reserve(_capacity ? _capacity * 2 : 16);
+		}
+
 		void reserve(u32 size)
 		{
 			if (_capacity >= size)
@@ -934,7 +940,7 @@ namespace rsx
 		{
 			if (_size >= _capacity)
 			{
-				reserve(_capacity + 16);
+				grow();
 			}
 
 			_data[_size++] = val;
@@ -944,7 +950,7 @@ namespace rsx
 		{
 			if (_size >= _capacity)
 			{
-				reserve(_capacity + 16);
+				grow();
 			}
 
 			_data[_size++] = val;
@@ -957,7 +963,7 @@ namespace rsx
 
 			if (_size >= _capacity)
 			{
-				reserve(_capacity + 16);
+				grow();
 				pos = _data + _loc;
 			}
 
@@ -985,7 +991,7 @@ namespace rsx
 
 			if (_size >= _capacity)
 			{
-				reserve(_capacity + 16);
+				grow();
 				pos = _data + _loc;
 			}
 
@@ -107,7 +107,15 @@ struct push_buffer_vertex_info
 			attribute_mask = 0;
 
 			vertex_count++;
-			data.resize(vertex_count * vertex_size);
+
+			// Storage is kept across draws and grown geometrically, so a new vertex normally costs no allocation
+			const u32 required = vertex_count * vertex_size;
+			if (required > data.capacity())
+			{
+				data.reserve(std::max(required, data.capacity() * 2));
+			}
+
+			data.resize(required);
 		}
 
 		attribute_mask |= element_mask;
@@ -310,6 +310,9 @@ void Emulator::Init()
 	// Reload global configuration
 	g_cfg.from_string(fs::file(fs::get_config_dir() + "/config.yml", fs::read + fs::create).to_string());
 
+	logs::set_compression_level(g_cfg.misc.log_compression_level);
+	logs::set_binary(g_cfg.misc.binary_log);
+
 	// Create directories (can be disabled if necessary)
 	const std::string emu_dir = GetEmuDir();
 	const std::string dev_hdd0 = GetHddDir();
@@ -934,6 +937,9 @@ void Emulator::Load(const std::string& title_id, bool add_only, bool force_globa
 
 		LOG_NOTICE(LOADER, "Used configuration:\n%s\n", g_cfg.to_string());
 
+		logs::set_compression_level(g_cfg.misc.log_compression_level);
+		logs::set_binary(g_cfg.misc.binary_log);
+
 		// Set RTM usage
 		g_use_rtm = utils::has_rtm() && ((utils::has_mpx() && g_cfg.core.enable_TSX == tsx_usage::enabled) || g_cfg.core.enable_TSX == tsx_usage::forced);
 
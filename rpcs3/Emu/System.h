@@ -383,6 +383,7 @@ struct cfg_root : cfg::node
 		cfg::string llvm_cpu{this, "Use LLVM CPU"};
 		cfg::_int<0, INT32_MAX> llvm_threads{this, "Max LLVM Compile Threads", 0};
 		cfg::_bool thread_scheduler_enabled{this, "Enable thread scheduler", thread_scheduler_enabled_def};
+		cfg::_int<0, 32> reserved_cores{this, "Reserved physical cores", 0}; // Kept free of PPU/SPU/RSX threads by the thread scheduler
 		cfg::_bool set_daz_and_ftz{this, "Set DAZ and FTZ", false};
 		cfg::_enum<spu_decoder_type> spu_decoder{this, "SPU Decoder", spu_decoder_type::llvm};
 		cfg::_bool lower_spu_priority{this, "Lower SPU thread priority"};
@@ -432,6 +433,7 @@ struct cfg_root : cfg::node
 
 		cfg::_bool limit_cache_size{this, "Limit disk cache size", false};
 		cfg::_int<0, 10240> cache_max_size{this, "Disk cache maximum size (MB)", 5120};
+		cfg::_bool cache_decrypted_self{this, "Cache decrypted executables", false};
 
 	} vfs{this};
 
@@ -469,6 +471,10 @@ struct cfg_root : cfg::node
 		cfg::_bool full_rgb_range_output{this, "Use full RGB output range", true}; // Video out dynamic range
 		cfg::_bool disable_asynchronous_shader_compiler{this, "Disable Asynchronous Shader Compiler", false};
 		cfg::_bool strict_texture_flushing{this, "Strict Texture Flushing", false};
+		cfg::_bool hash_verified_textures{this, "Hash-Verified Texture Sections", false}; // Frequently written textures are checked by hash instead of page protection
+		cfg::_bool stage_speculative_readbacks{this, "Stage Speculative Readbacks", false}; // Predicted surface readbacks are copied to host memory before the CPU accesses them
+		cfg::_bool frame_timing_log{this, "Log Frame Timings", false}; // Writes a breakdown of the RSX thread time of every frame to RSX_frame_timings.csv
+		cfg::_bool frame_timing_log_json{this, "Log Frame Timings As JSON", false}; // Writes JSON lines to RSX_frame_timings.jsonl instead
 		cfg::_bool disable_native_float16{this, "Disable native float16 support", false};
 		cfg::_bool multithreaded_rsx{this, "Multithreaded RSX", false};
 		cfg::_int<1, 8> consequtive_frames_to_draw{this, "Consecutive Frames To Draw", 1};
@@ -602,6 +608,8 @@ struct cfg_root : cfg::node
 		cfg::_bool show_shader_compilation_hint{ this, "Show shader compilation hint", true };
 		cfg::_bool use_native_interface{ this, "Use native user interface", true };
 		cfg::_int<1, 65535> gdb_server_port{this, "Port", 2345};
+		cfg::_bool binary_log{ this, "Write binary log" };
+		cfg::_int<0, 9> log_compression_level{ this, "Log compression level", 9 };
 
 	} misc{this};
 
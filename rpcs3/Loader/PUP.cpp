@@ -1,6 +1,13 @@
 ﻿#include "stdafx.h"
 
 #include "PUP.h"
+#include "Crypto/unself.h"
+#include "Crypto/key_vault.h"
+#include "Utilities/Thread.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
 
 pup_object::pup_object(const fs::file& file): m_file(file)
 {
@@ -40,3 +47,121 @@ fs::file pup_object::get_file(u64 entry_id)
 	}
 	return fs::file();
 }
+
+pup_installer::pup_installer(pup_object& pup)
+	: m_update_files_f(pup.get_file(0x300))
+	, m_update_files(m_update_files_f)
+{
+	m_filenames = m_update_files.get_filenames();
+
+	m_filenames.erase(std::remove_if(m_filenames.begin(), m_filenames.end(), [](const std::string& s) { return s.find("dev_flash_") == std::string::npos; }), m_filenames.end());
+
+	m_version = pup.get_file(0x100).to_string();
+
+	const std::size_t version_pos = m_version.find('\n');
+
+	if (version_pos != std::string::npos)
+	{
+		m_version.erase(version_pos);
+	}
+}
+
+bool pup_installer::install(const std::string& dev_flash, atomic_t<int>& progress, u32 max_threads)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	const u32 num_threads = std::clamp<u32>(max_threads ? max_threads : std::thread::hardware_concurrency(), 1, std::max<u32>(get_count(), 1));
+
+	// The update archive is read from a single stream
+	std::mutex update_files_mutex;
+	std::mutex error_mutex;
+	atomic_t<u32> next_file{0};
+
+	auto fail = [&](const std::string& error)
+	{
+		std::lock_guard lock(error_mutex);
+
+		if (m_error.empty())
+		{
+			m_error = error;
+		}
+
+		progress = -1;
+	};
+
+	auto worker = [&]()
+	{
+		for (u32 index; progress >= 0 && (index = next_file++) < get_count();)
+		{
+			const std::string& filename = m_filenames[index];
+			const auto file_start = std::chrono::steady_clock::now();
+
+			fs::file update_file;
+			{
+				std::lock_guard lock(update_files_mutex);
+				update_file = m_update_files.get_file(filename);
+			}
+
+			SCEDecrypter self_dec(update_file);
+			self_dec.LoadHeaders();
+			self_dec.LoadMetadata(SCEPKG_ERK, SCEPKG_RIV);
+			self_dec.DecryptData();
+
+			auto dev_flash_tar_f = self_dec.MakeFile();
+
+			if (dev_flash_tar_f.size() < 3)
+			{
+				LOG_ERROR(LOADER, "Firmware: %s could not be decrypted", filename);
+				fail("PUP contents are invalid.");
+				break;
+			}
+
+			const auto decrypted = std::chrono::steady_clock::now();
+
+			tar_object dev_flash_tar(dev_flash_tar_f[2]);
+
+			if (!dev_flash_tar.extract(dev_flash, "dev_flash/"))
+			{
+				LOG_ERROR(LOADER, "Firmware: %s could not be extracted", filename);
+				fail("TAR contents are invalid.");
+				break;
+			}
+
+			const auto extracted = std::chrono::steady_clock::now();
+
+			LOG_NOTICE(LOADER, "Firmware: Installed %s (decryption: %.1fms, extraction: %.1fms)", filename,
+				std::chrono::duration<double, std::milli>(decrypted - file_start).count(),
+				std::chrono::duration<double, std::milli>(extracted - decrypted).count());
+
+			progress.atomic_op([](int& value)
+			{
+				if (value >= 0)
+				{
+					value++;
+				}
+			});
+		}
+	};
+
+	{
+		std::deque<named_thread<std::function<void()>>> threads;
+
+		for (u32 i = 0; i < num_threads; i++)
+		{
+			threads.emplace_back(fmt::format("Firmware Installer %u", i), worker);
+		}
+	}
+
+	if (progress < 0)
+	{
+		if (m_error.empty())
+		{
+			LOG_ERROR(LOADER, "Firmware: Installation cancelled");
+		}
+
+		return false;
+	}
+
+	LOG_SUCCESS(LOADER, "Firmware: Installed %u archives in %.3fs (%u threads)", get_count(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), num_threads);
+	return true;
+}
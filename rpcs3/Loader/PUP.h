@@ -2,6 +2,8 @@
 
 #include "../../Utilities/types.h"
 #include "../../Utilities/File.h"
+#include "../../Utilities/Atomic.h"
+#include "TAR.h"
 
 #include <vector>
 
@@ -45,3 +47,39 @@ public:
 
 	fs::file get_file(u64 entry_id);
 };
+
+// Installs the dev_flash archives of an update package, decrypting and extracting several archives at once
+class pup_installer
+{
+	fs::file m_update_files_f;
+	tar_object m_update_files;
+
+	std::vector<std::string> m_filenames;
+	std::string m_version;
+	std::string m_error;
+
+public:
+	pup_installer(pup_object& pup);
+
+	// Firmware version of the package (for example "4.84")
+	const std::string& get_version() const
+	{
+		return m_version;
+	}
+
+	// Number of dev_flash archives, progress is counted in them
+	u32 get_count() const
+	{
+		return ::size32(m_filenames);
+	}
+
+	// Description of the failure, empty if the installation was cancelled
+	const std::string& get_error() const
+	{
+		return m_error;
+	}
+
+	// Extract to dev_flash using up to max_threads threads (0 = all hardware threads).
+	// Progress is set to -1 on failure, setting it to -1 cancels the installation.
+	bool install(const std::string& dev_flash, atomic_t<int>& progress, u32 max_threads = 0);
+};
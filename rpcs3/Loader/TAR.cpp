@@ -113,6 +113,19 @@ bool tar_object::extract(std::string path, std::string ignore)
 		case '0':
 		{
 			fs::file file(result, fs::rewrite);
+
+			if (!file)
+			{
+				// The directory may be part of another archive extracted at the same time
+				fs::create_path(fs::get_parent_dir(result));
+
+				if (!file.open(result, fs::rewrite))
+				{
+					LOG_ERROR(GENERAL, "TAR Loader: failed to create file %s (%s)", result, fs::g_tls_error);
+					return false;
+				}
+			}
+
 			file.write(get_file(header.name).to_vector<u8>());
 			break;
 		}
@@ -23,6 +23,9 @@
 #endif
 
 #include "rpcs3_version.h"
+#include "Emu/RSX/Common/upload_benchmark.h"
+#include "Crypto/crypto_benchmark.h"
+#include "Loader/PUP.h"
 
 inline std::string sstr(const QString& _in) { return _in.toStdString(); }
 
@@ -108,6 +111,57 @@ int main(int argc, char** argv)
 		std::fprintf(stderr, "Failed to set max open file limit (4096).");
 #endif
 
+	// Standalone RSX upload benchmark, runs without a window so it can be used on headless CI machines
+	if (argc > 1 && std::strcmp(argv[1], "--rsx-upload-benchmark") == 0)
+	{
+		return rsx::run_upload_benchmark(argc > 2 ? argv[2] : "", argc > 3 ? argv[3] : "") ? 1 : 0;
+	}
+
+	// Standalone AES/SHA-1 throughput benchmark
+	if (argc > 1 && std::strcmp(argv[1], "--crypto-benchmark") == 0)
+	{
+		run_crypto_benchmark(argc > 2 ? argv[2] : "");
+		return 0;
+	}
+
+	// Convert a binary log (see "Write binary log" option) to text
+	if (argc > 2 && std::strcmp(argv[1], "--decode-log") == 0)
+	{
+		return logs::decode_binary_log(argv[2], argc > 3 ? argv[3] : "") ? 0 : 1;
+	}
+
+	// Install firmware without the GUI (the dev_flash directory is given because no configuration is loaded here)
+	if (argc > 3 && std::strcmp(argv[1], "--installfw") == 0)
+	{
+		const fs::file pup_f(argv[2]);
+		pup_object pup(pup_f);
+
+		if (!pup)
+		{
+			std::fprintf(stderr, "Invalid PUP file: %s\n", argv[2]);
+			return 1;
+		}
+
+		std::string dev_flash = argv[3];
+
+		if (!dev_flash.empty() && dev_flash.back() != '/' && dev_flash.back() != '\\')
+		{
+			dev_flash += '/';
+		}
+
+		pup_installer installer(pup);
+		atomic_t<int> progress(0);
+
+		if (!installer.install(dev_flash, progress))
+		{
+			std::fprintf(stderr, "Firmware installation failed: %s\n", installer.get_error().c_str());
+			return 1;
+		}
+
+		std::printf("Installed firmware %s to %s\n", installer.get_version().c_str(), dev_flash.c_str());
+		return 0;
+	}
+
 	QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 	QCoreApplication::setAttribute(Qt::AA_DisableWindowContextHelpButton);
 	QCoreApplication::setAttribute(Qt::AA_DontCheckOpenGLContextThreadAffinity);
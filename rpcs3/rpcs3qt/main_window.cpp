@@ -561,20 +561,9 @@ void main_window::InstallPup(const QString& dropPath)
 		return;
 	}
 
-	fs::file update_files_f = pup.get_file(0x300);
-	tar_object update_files(update_files_f);
-	auto updatefilenames = update_files.get_filenames();
+	pup_installer installer(pup);
 
-	updatefilenames.erase(std::remove_if(
-		updatefilenames.begin(), updatefilenames.end(), [](std::string s) { return s.find("dev_flash_") == std::string::npos; }),
-		updatefilenames.end());
-
-	std::string version_string = pup.get_file(0x100).to_string();
-	size_t version_pos = version_string.find('\n');
-	if (version_pos != std::string::npos)
-	{
-		version_string.erase(version_pos);
-	}
+	const std::string& version_string = installer.get_version();
 
 	const std::string cur_version = "4.84";
 
@@ -585,7 +574,7 @@ void main_window::InstallPup(const QString& dropPath)
 		return;
 	}
 
-	progress_dialog pdlg(tr("Installing firmware version %1\nPlease wait...").arg(qstr(version_string)), tr("Cancel"), 0, static_cast<int>(updatefilenames.size()), this);
+	progress_dialog pdlg(tr("Installing firmware version %1\nPlease wait...").arg(qstr(version_string)), tr("Cancel"), 0, static_cast<int>(installer.get_count()), this);
 	pdlg.setWindowTitle(tr("RPCS3 Firmware Installer"));
 	pdlg.show();
 
@@ -595,40 +584,11 @@ void main_window::InstallPup(const QString& dropPath)
 		// Run asynchronously
 		named_thread worker("Firmware Installer", [&]
 		{
-			for (const auto& updatefilename : updatefilenames)
-			{
-				if (progress == -1) break;
-
-				fs::file updatefile = update_files.get_file(updatefilename);
-
-				SCEDecrypter self_dec(updatefile);
-				self_dec.LoadHeaders();
-				self_dec.LoadMetadata(SCEPKG_ERK, SCEPKG_RIV);
-				self_dec.DecryptData();
-
-				auto dev_flash_tar_f = self_dec.MakeFile();
-				if (dev_flash_tar_f.size() < 3)
-				{
-					LOG_ERROR(GENERAL, "Error while installing firmware: PUP contents are invalid.");
-					QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: PUP contents are invalid."));
-					progress = -1;
-				}
-
-				tar_object dev_flash_tar(dev_flash_tar_f[2]);
-				if (!dev_flash_tar.extract(g_cfg.vfs.get_dev_flash(), "dev_flash/"))
-				{
-					LOG_ERROR(GENERAL, "Error while installing firmware: TAR contents are invalid.");
-					QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: TAR contents are invalid."));
-					progress = -1;
-				}
-
-				if (progress >= 0)
-					progress += 1;
-			}
+			return installer.install(g_cfg.vfs.get_dev_flash(), progress);
 		});
 
 		// Wait for the completion
-		while (std::this_thread::sleep_for(5ms), std::abs(progress) < pdlg.maximum())
+		while (std::this_thread::sleep_for(5ms), worker != thread_state::finished)
 		{
 			if (pdlg.wasCanceled())
 			{
@@ -640,7 +600,17 @@ void main_window::InstallPup(const QString& dropPath)
 			QCoreApplication::processEvents();
 		}
 
-		update_files_f.close();
+		if (!worker())
+		{
+			progress = -1;
+
+			if (!installer.get_error().empty())
+			{
+				LOG_ERROR(GENERAL, "Error while installing firmware: %s", installer.get_error());
+				QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: %1").arg(qstr(installer.get_error())));
+			}
+		}
+
 		pup_f.close();
 
 		if (progress > 0)